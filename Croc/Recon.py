@@ -56,6 +56,15 @@ class HL38Config:
         self.recon = recon
         self.endScript = end_config
         self.detailedRatioPrint = []
+        self.adaptiveTimeline = None
+        self.progressiveRecon = None
+        self.resultsProcessors = None
+        self.bootstrapCache = None
+        self.bootstrapSeed = None
+        self.bootstrapErrors = None
+        self.bootstrapQuantiles = None
+        self.bootstrapBinWidth = None
+        self.endmemberReplicates = None
         self.filterList = []
         self.reconSystems = []
         self.DB = None
@@ -76,6 +85,75 @@ class HL38Config:
         self.kernelWidth = kernelW
         return self
 
+    def AdaptiveTimeline(self, coarseStep = 100, minStep = 1, tolerance = 0.5):
+        """
+        Run the reconstruction on a coarse timeline, bisecting intervals only where the
+        endmember medians of neighbouring timesteps shift by more than 'tolerance' band widths.
+        """
+        self.adaptiveTimeline = (coarseStep, minStep, tolerance)
+        return self
+
+    def ProgressiveRecon(self, coarseStep = 160, previewIter = 20000, tolerance = 0.1, timeBudget = 0):
+        """
+        Settings for Visualiser.TimelinePreview: a quick preview on a 'coarseStep' grid with
+        'previewIter' MCMC iterations, refined in the background until the medians move by
+        less than 'tolerance' band widths or 'timeBudget' seconds pass (0 = no limit).
+        """
+        self.progressiveRecon = (coarseStep, previewIter, tolerance, timeBudget)
+        return self
+
+    def UseResultsProcessors(self, pList):
+        """
+        Collect several outputs from a single MCMC run. 'pList' names the results processors
+        ("Endmembers", "Ratios", "Elements", "Diagnostics"); the first one is the primary output.
+        """
+        self.resultsProcessors = pList
+        return self
+
+    def BootstrapCache(self, path, seed = None):
+        """
+        Directory of the on-disk bootstrap cache, shared between processes (off by default).
+        Files are never deleted. A fixed 'seed' lets bootstraps be reused from the cache by any
+        later run; without one, every run draws new seeds, so its files are never hit again.
+        """
+        self.bootstrapCache = path
+        self.bootstrapSeed = seed
+        return self
+
+    def AnalyticBootstrapErrors(self, analytic = True):
+        """
+        Compute bootstrap standard errors in closed form (delta method) instead of from
+        10000 resamples; much faster for scans, resampling remains the default for final runs.
+        """
+        self.bootstrapErrors = "Analytic" if analytic else "Resample"
+        return self
+
+    def BootstrapQuantiles(self, keep = True):
+        """
+        Keep a quantile sketch of the resamples at every point of each bootstrap, giving true
+        percentile bands (WRB_Result.PercentileCurve); off by default, as it costs memory and cache space.
+        """
+        self.bootstrapQuantiles = keep
+        return self
+
+    def BinnedBootstrap(self, binWidth):
+        """
+        Approximate bootstrap kernel sums by binning the samples onto an age grid of 'binWidth'
+        (Myr), for large databases; each kernel weight is then off by at most (binWidth / width)^2 / 8
+        of the kernel peak.
+        """
+        self.bootstrapBinWidth = binWidth
+        return self
+
+    def EndmemberReplicates(self, replicates):
+        """
+        Propagate the sampling uncertainty of the endmember databases through the MCMC, via a bank of
+        'replicates' bootstrap replicates of every endmember at every timestep (drawn from by each proposal),
+        instead of the analytic endmember ratio errors. Continuous, Exponential & FuturePast endmembers only.
+        """
+        self.endmemberReplicates = replicates
+        return self
+
     def UseDetailedRatioPrinter(self, rList):
         """
         Print detailed confidence interval statistics for the ratios
@@ -166,6 +244,30 @@ class HL38Config:
                 confdict["rA"].append(A)
                 confdict["rB"].append(B)
                 confdict["r"].append(r)
+        if self.adaptiveTimeline is not None:
+            confdict["timelineMode"] = "Adaptive"
+            confdict["AdaptiveCoarseStep"] = str(self.adaptiveTimeline[0])
+            confdict["AdaptiveMinStep"] = str(self.adaptiveTimeline[1])
+            confdict["AdaptiveTolerance"] = str(self.adaptiveTimeline[2])
+        if self.progressiveRecon is not None:
+            confdict["ProgressiveCoarseStep"] = str(self.progressiveRecon[0])
+            confdict["ProgressivePreviewIter"] = str(self.progressiveRecon[1])
+            confdict["ProgressiveTolerance"] = str(self.progressiveRecon[2])
+            confdict["ProgressiveTimeBudget"] = str(self.progressiveRecon[3])
+        if self.bootstrapCache is not None:
+            confdict["BootstrapCache"] = self.bootstrapCache
+        if self.bootstrapSeed is not None:
+            confdict["BootstrapSeed"] = str(self.bootstrapSeed)
+        if self.bootstrapErrors is not None:
+            confdict["BootstrapErrors"] = self.bootstrapErrors
+        if self.bootstrapQuantiles is not None:
+            confdict["BootstrapQuantiles"] = "1" if self.bootstrapQuantiles else "0"
+        if self.bootstrapBinWidth is not None:
+            confdict["BootstrapBinWidth"] = str(self.bootstrapBinWidth)
+        if self.endmemberReplicates is not None:
+            confdict["EndmemberReplicates"] = str(self.endmemberReplicates)
+        if self.resultsProcessors:
+            confdict["resultsProcessors"] = list(self.resultsProcessors)
         if self.detailedRatioPrint:
             confdict["detailedRatioPrinter"] = []
             for r in self.detailedRatioPrint:
@@ -187,6 +289,38 @@ class HL38Config:
                 RM.AddBootstrap(Bootstrap.GetCached(r, RM))
         return RM
 
+def ResultsTableArrays(table):
+    """
+    Return the columns of a HL38 ResultsTable as a {column name: numpy array} dictionary.
+    The arrays share memory with the table, and are read-only.
+    """
+    return {name: np.frombuffer(table.Column(name), dtype=np.float64) for name in table.ColumnNames()}
+
+def EvaluateCurve(f, x, out=None):
+    """
+    Evaluate a HL38 DiscreteFunction at every point of the array 'x', NumPy ufunc-style.
+    The result is written into 'out' (a float64 array shaped like x) if given, and returned.
+    """
+    x = np.ascontiguousarray(x, dtype=np.float64)
+    if out is None:
+        out = np.empty_like(x)
+    elif not out.flags.c_contiguous:
+        raise ValueError("'out' must be a contiguous array")
+    f.EvaluateInto(x.reshape(-1), out.reshape(-1))
+    return out
+
+def ResultsTableFrame(table):
+    """
+    Convert a HL38 ResultsTable into a DataFrame
+    """
+    return pandas.DataFrame(ResultsTableArrays(table))
+
+def ReadResultsTable(path):
+    """
+    Load a binary results table (as written by ReconManager.RunReconstructionToFiles) into a DataFrame
+    """
+    return ResultsTableFrame(HL38.ResultsTable.ReadBinary(path))
+
 class Visualiser:
     """
     Holds common state for visualising reconstructions.
@@ -248,6 +382,44 @@ class Visualiser:
         self.WritePlot(fname, 8, 6)
         return self
 
+    def TimelineReconTables(self):
+        """
+        Run the C++ reconstruction once, returning the output of every results processor
+        as a DataFrame, without going through CSV.
+        """
+        return {name: ResultsTableFrame(table) for name, table in self.RM.RunReconstructionTables().items()}
+
+    def TimelineReconAll(self):
+        """
+        Run the C++ reconstruction once, saving the output of every results processor as a csv file.
+        Returns a dictionary of DataFrames, keyed by results processor name.
+        """
+        fname= self.config.ToFilename("b")
+        outputs = {}
+        for name, recon in self.RM.RunReconstructionAll().items():
+            with open("cout/"+fname+"_"+name+".csv", "w") as wfile:
+                wfile.write(recon)
+            outputs[name] = pandas.read_csv(StringIO(recon))
+        return outputs
+
+    def TimelinePreview(self):
+        """
+        Start a progressive reconstruction; returns the coarse preview as a DataFrame
+        while the timeline keeps being refined in the background.
+        Adding ratios or bootstraps (or resetting them) stops the refinement first;
+        forward models and snapshots may be used while it runs.
+        """
+        return pandas.read_csv(StringIO(self.RM.StartProgressiveReconstruction()))
+
+    def TimelineSnapshot(self):
+        """
+        Return the latest state of the progressive reconstruction as a DataFrame
+        """
+        return pandas.read_csv(StringIO(self.RM.GetReconstructionSnapshot()))
+
+    def IsRefining(self):
+        return self.RM.IsRefining()
+
     def CompareArchaModern(self):
         """
         Create a figure comparing the Archaean and Modern MCMC states
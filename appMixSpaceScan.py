@@ -36,7 +36,7 @@ def PrepC(fR, sys_list):
     c = Recon.HL38Config(Recon.EndmemberType.Dual,
                          Recon.ReconType.MCMC,
                          Recon.EndmemberConfig.KMF, 500.0)
-    c.ReconSystems(sys_list).FilterResult(fR)
+    c.ReconSystems(sys_list).FilterResult(fR).BootstrapQuantiles(False)
     return c
 
 def PrepRM(fR, sys_list):
@@ -186,11 +186,12 @@ if __name__ == '__main__':
     cSize = len(r_set)
     if cSize > 0:
         print("NOW CACHING "+str(cSize)+" BOOTSTRAPS...")
-        for ratio, it in zip(list(r_set), range(cSize)):
-            print("T: "+str(datetime.datetime.now()))
-            print("BOOTSTRAP "+str(ratio)+": "+str(it)+"/"+str(cSize)+" ("+str(100.0 * float(it)/float(cSize))+"%)")
-            [A, B] = DecomposeR(ratio)
-            boot = cRM.GenerateBootstrap(A, B)
+        print("T: "+str(datetime.datetime.now()))
+        r_list = list(r_set)
+        AB = [DecomposeR(ratio) for ratio in r_list]
+        #All remaining ratios are bootstrapped together, sharing their resamples
+        boots = cRM.GenerateBootstraps([a for [a, b] in AB], [b for [a, b] in AB])
+        for ratio, boot in zip(r_list, boots):
             bootcache[ratio] = MiniBootstrap(boot.stdError.LastY(), boot.stdError.FirstY()) #Load mini python bootstraps instead of full-sized C++ ones, so we can easily pass them to other processes afterwards!
         wbfile = open(bcache_file, "wb")
         pickle.dump(bootcache, wbfile)
@@ -164,6 +164,198 @@ T ComputeStdErr(const std::vector<T>& V) {
 	return stDev / sN;
 };
 
+//Online mean, variance & kurtosis (Welford; higher moments after Pebay), for values that are never stored
+struct RunningStats {
+	double n = 0.0;
+	double mean = 0.0;
+	double M2 = 0.0;
+	double M3 = 0.0;
+	double M4 = 0.0;
+
+	void Add(double x) {
+		double n1 = n;
+		n += 1.0;
+		double d = x - mean;
+		double dn = d / n;
+		double dn2 = dn * dn;
+		double term = d * dn * n1;
+		mean += dn;
+		M4 += term * dn2 * (n * n - 3.0 * n + 3.0) + 6.0 * dn2 * M2 - 4.0 * dn * M3;
+		M3 += term * dn * (n - 2.0) - 3.0 * dn * M2;
+		M2 += term;
+	};
+	//Combines the statistics of two disjoint sets of values
+	void Merge(const RunningStats& o) {
+		if (o.n == 0.0) {
+			return;
+		};
+		double na = n;
+		double nb = o.n;
+		double total = na + nb;
+		double d = o.mean - mean;
+		double d2 = d * d;
+		M4 += o.M4 + d2 * d2 * na * nb * (na * na - na * nb + nb * nb) / (total * total * total)
+			+ 6.0 * d2 * (na * na * o.M2 + nb * nb * M2) / (total * total) + 4.0 * d * (na * o.M3 - nb * M3) / total;
+		M3 += o.M3 + d2 * d * na * nb * (na - nb) / (total * total) + 3.0 * d * (na * o.M2 - nb * M2) / total;
+		M2 += o.M2 + d2 * na * nb / total;
+		mean += d * nb / total;
+		n = total;
+	};
+	//Approximate relative standard error of SampleStdDev, sqrt((kurtosis - 1) / n) / 2 (infinite for fewer than 4 values)
+	double StdDevRelativeError() const {
+		if (n < 4.0) {
+			return INFINITY;
+		};
+		if (M2 <= 0.0) {
+			return 0.0;
+		};
+		double kurtosis = n * M4 / (M2 * M2);
+		return 0.5 * sqrt(std::max(0.0, kurtosis - 1.0) / n);
+	};
+	//Same convention as ComputeSampleStdDev
+	double SampleStdDev() const {
+		if (n == 0.0) {
+			return 0.0;
+		};
+		return sqrt(M2 / (n - 1.0));
+	};
+};
+
+//Streaming quantile estimate of a set of values (a merging t-digest): values are buffered, then merged into centroids whose size
+//shrinks towards both tails, so that memory stays bounded by the compression while extreme quantiles remain accurate
+class QuantileSketch {
+	struct Centroid {
+		double mean;
+		double weight;
+		bool operator<(const Centroid& rhs) const { return mean < rhs.mean; };
+	};
+	double compression;
+	double minV = INFINITY;
+	double maxV = -INFINITY;
+	std::vector<Centroid> centroids;
+	std::vector<Centroid> buffer;
+
+	//Scale function (& inverse) of the t-digest, mapping quantiles to centroid indices
+	double K(double q) const { return compression / (2.0 * M_PI) * asin(2.0 * q - 1.0); };
+	double Q(double k) const { return (k >= compression / 4.0) ? 1.0 : (sin(2.0 * M_PI * k / compression) + 1.0) / 2.0; };
+public:
+	QuantileSketch(double COMPRESSION = 200.0) : compression(COMPRESSION) {};
+
+	void Add(double x) {
+		minV = std::min(minV, x);
+		maxV = std::max(maxV, x);
+		buffer.push_back({ x, 1.0 });
+		if (buffer.size() >= (size_t)(2.0 * compression)) {
+			Compress();
+		};
+	};
+	//Combines the sketches of two disjoint sets of values
+	void Merge(const QuantileSketch& o) {
+		minV = std::min(minV, o.minV);
+		maxV = std::max(maxV, o.maxV);
+		buffer.insert(buffer.end(), o.centroids.begin(), o.centroids.end());
+		buffer.insert(buffer.end(), o.buffer.begin(), o.buffer.end());
+		Compress();
+	};
+	//Merges all buffered values into the centroids
+	void Compress() {
+		if (buffer.empty()) {
+			return;
+		};
+		buffer.insert(buffer.end(), centroids.begin(), centroids.end());
+		std::sort(buffer.begin(), buffer.end());
+		double total = 0.0;
+		for (const auto& c : buffer) {
+			total += c.weight;
+		};
+		centroids.clear();
+		Centroid cur = buffer.front();
+		double below = 0.0;
+		double limit = total * Q(K(0.0) + 1.0);
+		for (size_t i = 1; i < buffer.size(); ++i) {
+			const Centroid& c = buffer[i];
+			if (below + cur.weight + c.weight <= limit) {
+				cur.weight += c.weight;
+				cur.mean += (c.mean - cur.mean) * c.weight / cur.weight;
+			} else {
+				below += cur.weight;
+				centroids.push_back(cur);
+				limit = total * Q(K(below / total) + 1.0);
+				cur = c;
+			};
+		};
+		centroids.push_back(cur);
+		buffer.clear();
+	};
+	//Compresses & releases the buffer, leaving only the centroids
+	void Shrink() {
+		Compress();
+		buffer.shrink_to_fit();
+		centroids.shrink_to_fit();
+	};
+
+	//Flat representation (compression, minimum, maximum, then the mean & weight of every centroid), e.g. for storage
+	std::vector<double> ToArray() const {
+		QuantileSketch compressed(*this);
+		compressed.Compress();
+		std::vector<double> V = { compression, minV, maxV };
+		for (const auto& c : compressed.centroids) {
+			V.push_back(c.mean);
+			V.push_back(c.weight);
+		};
+		return V;
+	};
+	static QuantileSketch FromArray(const double* V, size_t n) {
+		QuantileSketch s(V[0]);
+		s.minV = V[1];
+		s.maxV = V[2];
+		for (size_t i = 3; i + 1 < n; i += 2) {
+			s.centroids.push_back({ V[i], V[i + 1] });
+		};
+		return s;
+	};
+
+	double Count() const {
+		double n = 0.0;
+		for (const auto& c : centroids) {
+			n += c.weight;
+		};
+		for (const auto& c : buffer) {
+			n += c.weight;
+		};
+		return n;
+	};
+	//Percentile (0-100) of the values, interpolated between centroid centres & the extremes (NaN if empty)
+	double Percentile(double percentile) const {
+		if (!buffer.empty()) {
+			QuantileSketch compressed(*this);
+			compressed.Compress();
+			return compressed.Percentile(percentile);
+		};
+		if (centroids.empty()) {
+			return NAN;
+		};
+		double total = Count();
+		double rank = std::min(std::max(percentile / 100.0, 0.0), 1.0) * total;
+		//Every centroid's mass is centred on its mean
+		double prevRank = 0.0;
+		double prevMean = minV;
+		double cumulative = 0.0;
+		for (const auto& c : centroids) {
+			double centre = cumulative + c.weight / 2.0;
+			if (rank < centre) {
+				double f = (centre > prevRank) ? (rank - prevRank) / (centre - prevRank) : 0.0;
+				return prevMean + f * (c.mean - prevMean);
+			};
+			prevRank = centre;
+			prevMean = c.mean;
+			cumulative += c.weight;
+		};
+		double f = (total > prevRank) ? (rank - prevRank) / (total - prevRank) : 0.0;
+		return prevMean + f * (maxV - prevMean);
+	};
+};
+
 template<typename T>
 T ComputeMedian(const std::vector<T>& V) {
 	if (V.size()==0)
@@ -189,6 +381,32 @@ inline T SortedVectorPercentile(const std::vector<T>& sortedVector, double perce
 	};
 };
 
+//Returns the same value as SortedVectorPercentile, but for an unsorted range of n values
+//Only partially reorders the range (linear time), so it may be called repeatedly on the same data
+template<typename T>
+inline T SelectRangePercentile(T* V, size_t n, double percentile) {
+	double IDXd = (percentile / 100.0)*((double)n);
+	size_t IDXi = std::min((size_t)IDXd, n - 1);
+	std::nth_element(V, V + IDXi, V + n);
+	T mid = V[IDXi];
+	if ((IDXi + 1) <= (n - 1)) {
+		T next = *std::min_element(V + IDXi + 1, V + n);
+		if (IDXi != 0) {
+			T prev = *std::max_element(V, V + IDXi);
+			return (prev + mid + next) / 3;
+		} else {
+			return (mid + next) / 2;
+		};
+	} else {
+		return mid;
+	};
+};
+
+template<typename T>
+inline T SelectVectorPercentile(std::vector<T>& V, double percentile) {
+	return SelectRangePercentile(V.data(), V.size(), percentile);
+};
+
 template<typename T>
 T ComputePercentile(const std::vector<T>& V, double PER) {
 	if (V.size()==0)
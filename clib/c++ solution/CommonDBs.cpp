@@ -7,10 +7,12 @@ REGISTER_DB_MODULE(CommonDBs);
 void CommonDBs::Exec() {
 	KellerDatabase db_keller_unfiltered;
 	db_keller_unfiltered.SetName("Keller 2015").ParseDirectory("db/keller_web");
+	ClassifyLithology(db_keller_unfiltered);
 
 	StandardGeochemDatabase db_modernIgn_noOcean;
 	db_modernIgn_noOcean.SetName("Igneous continental").ParseDirectory("db/PetDB_NoOcean");
 	db_modernIgn_noOcean.Refilter(RangeFilter(OFF(RockSample::Age), 0, 1000));
+	ClassifyLithology(db_modernIgn_noOcean);
 
 	RockDatabase db_keller(db_keller_unfiltered.Select(FuncFilter(IsGood)));
 
@@ -4,6 +4,10 @@
 #include "pyLib.h"
 
 #include "WRB.h"
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
 
 //#define LOG_MCMC_STATE 1 
 
@@ -16,12 +20,12 @@ namespace MCMCRecon {
 	// Define various behaviours for different stages of the MCMC reconstruction pipeline
 	namespace Behaviour {
 		//MCMC new state generator: Arbitrary number of endmembers
-		template<int Ne>
-		inline MixState<Ne> StateGenerator_N(const MixState<Ne>& curFit) {
+		template<int Ne, typename RNG>
+		inline MixState<Ne> StateGenerator_N(const MixState<Ne>& curFit, RNG& rng) {
 			MixState<Ne> newFit;
 			double sum = 0.0;
 			for (int i = 1; i < Ne; ++i) { //Start at one, not zero!
-				newFit[i] = Random::NormDstr(curFit[i], JUMP_SZ);
+				newFit[i] = rng.NormDstr(curFit[i], JUMP_SZ);
 				sum += newFit[i];
 			};
 			newFit[0] = 1.0 - sum;
@@ -57,27 +61,27 @@ namespace MCMCRecon {
 	// Initialises endmember arrays for a given timestep
 	// 
 	template<int Ne>
-	inline void InitEndmemberData(const ReconManager& RM, double t, Endmembers* e, double* endNmntr, double* endDmntr, double* endErr) {
+	inline void InitEndmemberData(const ReconManager& RM, const EndmemberState& e, double* endNmntr, double* endDmntr, double* endErr) {
 		const size_t Nsys = RM.CountRatios();
-		e->RecalculateForTime(t);
 		for (size_t i = 0; i < Nsys; ++i) {
 			for (size_t j = 0; j < Ne; ++j) {
-				endNmntr[i*Ne + j] = RM.Nmntr[i](e->E[j]);
-				endDmntr[i*Ne + j] = RM.Dmntr[i](e->E[j]);
+				endNmntr[i*Ne + j] = RM.Nmntr[i](e.E[j]);
+				endDmntr[i*Ne + j] = RM.Dmntr[i](e.E[j]);
 			};
 		};
 		//Load standard errors of endmember ratios
 		for (size_t i = 0; i < Nsys; ++i) {
 			for (size_t j = 0; j < Ne; ++j) {
-				endErr[i*Ne + j] = e->ratioErr[j][i];
+				endErr[i*Ne + j] = e.ratioErr[j][i];
 			};
 		};
 	};
 
 	//Determine, via the Metropolis algorithm, whether the Markov Chain transitions into a new state or not
-	inline bool MetropolisAccept(double curChi2, double newChi2) {
+	template<typename RNG>
+	inline bool MetropolisAccept(double curChi2, double newChi2, RNG& rng) {
 		double r = exp(-newChi2 + curChi2);
-		double n = Random::Double();
+		double n = rng.Double();
 		return (r > n);
 	};
 
@@ -113,28 +117,47 @@ namespace MCMCRecon {
 
 	// The inner loop of the MCMC procedure
 	// The constraints and new state functions can be fully customized via templating
+	// The length of the chain is given by the size of mixStates
+	// Given a bank of endmember replicates (see EndmemberBank), the replicate is an auxiliary variable of the chain, whose
+	// endmembers replace endNmntr & endDmntr (endErr should then be zero). Proposals alternate between moving the mix and
+	// drawing a new replicate (uniformly), which keeps far more proposals acceptable than moving both at once.
+	// All random numbers are drawn from rng (Random::Global, or a Random::Stream owned by the caller).
 	template<int Ne,
-		MixState<Ne>(*GEN_NEW_STATE)(const MixState<Ne>&),
+		typename RNG,
+		MixState<Ne>(*GEN_NEW_STATE)(const MixState<Ne>&, RNG&),
 		bool(*CONSTRAINT_PASS)(const MixState<Ne>&)>
-	size_t inline MCMC_INNER_LOOP(MixState<Ne>& bestFit, std::vector<MixState<Ne>>& mixStates, double* gShale, double* gShaleErr, double* endNmntr, double* endDmntr, double* endErr, size_t Nsys) {
+	size_t inline MCMC_INNER_LOOP(RNG& rng, MixState<Ne>& bestFit, std::vector<MixState<Ne>>& mixStates, double* gShale, double* gShaleErr, double* endNmntr, double* endDmntr, double* endErr, size_t Nsys,
+								  const double* bank = nullptr, size_t replicates = 0) {
+		auto NMNTR = [&](size_t rep) -> const double* { return (replicates > 0) ? bank + rep * 2 * Ne * Nsys : endNmntr; };
+		auto DMNTR = [&](size_t rep) -> const double* { return (replicates > 0) ? bank + rep * 2 * Ne * Nsys + Ne * Nsys : endDmntr; };
 		MixState<Ne> initialFit = MixState<Ne>::Default();
 		bestFit = initialFit;
-		double bestChi2 = Chi2<Ne>(initialFit, gShale, gShaleErr, endNmntr, endDmntr, endErr, Nsys);
+		double bestChi2 = Chi2<Ne>(initialFit, gShale, gShaleErr, NMNTR(0), DMNTR(0), endErr, Nsys);
 		MixState<Ne> curFit, newFit;
 		double curChi2, newChi2;
+		size_t curRep = 0;
+		size_t newRep = 0;
 		curFit = bestFit;
 		curChi2 = bestChi2;
 		size_t acceptances = 0;
-		for (size_t mc = 0; mc < MC_ITER; ++mc) {
+		for (size_t mc = 0; mc < mixStates.size(); ++mc) {
 			//Generate a new proposal for the data which fits the hard constraints
-			do { newFit = GEN_NEW_STATE(curFit); }
-			while (!CONSTRAINT_PASS(newFit));
+			//(with a bank, every other proposal instead only moves to another replicate)
+			if (replicates > 0 && (mc % 2) == 1) {
+				newFit = curFit;
+				newRep = (size_t)rng.Int64(0, (int64)replicates - 1);
+			} else {
+				do { newFit = GEN_NEW_STATE(curFit, rng); }
+				while (!CONSTRAINT_PASS(newFit));
+				newRep = curRep;
+			};
 			//Compute Chi2 of new proposal
-			newChi2 = Chi2<Ne>(newFit, gShale, gShaleErr, endNmntr, endDmntr, endErr, Nsys);
+			newChi2 = Chi2<Ne>(newFit, gShale, gShaleErr, NMNTR(newRep), DMNTR(newRep), endErr, Nsys);
 			//Use the Metropolis criterion to determine if the Markov Chain transitions or not
-			if (MetropolisAccept(curChi2, newChi2)) {
+			if (MetropolisAccept(curChi2, newChi2, rng)) {
 				curFit = newFit;
 				curChi2 = newChi2;
+				curRep = newRep;
 				++acceptances;
 				//Keep track of the lowest chi2 value, update bestFit parameter accordingly
 				if (curChi2 < bestChi2) {
@@ -148,50 +171,118 @@ namespace MCMCRecon {
 		return acceptances;
 	};
 
-	//Full MCMC timeline reconstruction
-	template<int Ne,
-			typename RESULTS_PROCESSOR>
-	RESULTS_PROCESSOR inline RunMarkovModel_Impl(const ReconManager& RM) {
-		std::cout << "CRUSTAL MCMC REE-CONSTRUCTION INITIATED." << std::endl;
+	// Timeline over which a reconstruction is run
+	// Either a uniform grid, or a coarse grid which is adaptively bisected wherever the posterior changes quickly
+	struct TimelineSettings {
+		double timeStart;
+		double timeEnd;
+		double res;
+		bool adaptive;
+		double coarseRes;
+		double minRes;
+		double tolerance;
 
-		RESULTS_PROCESSOR results(RM);
-		size_t Nsys =        RM.CountRatios();
-		Endmembers* e =      RM.E;
-		double TIME_START =  4000.0;
-		double TIME_END =    0.0;
-		double RES =         10.0;
-		double REPORT_FREQ = 100.0;
-		double last_report = INFINITY;
-		double* gShale =     new double[Nsys];
-		double* gShaleErr =  new double[Nsys];
-		double* endNmntr =   new double[Ne * Nsys];
-		double* endDmntr =   new double[Ne * Nsys];
-		double* endErr =     new double[Ne * Nsys];
-		std::vector<MixState<Ne>> mixStates(MC_ITER);
-		std::vector<double>      chi2States(MC_ITER);
-		MixState<Ne>              bestFit;
+		TimelineSettings(const DenseStringMap& conf)
+			: timeStart(conf.GetOr("TimeStart", 4000.0)), timeEnd(conf.GetOr("TimeEnd", 0.0)), res(conf.GetOr("TimeStep", 10.0)),
+			  adaptive(conf.GetOr<std::string>("timelineMode", "Uniform") == "Adaptive"),
+			  coarseRes(conf.GetOr("AdaptiveCoarseStep", 100.0)), minRes(conf.GetOr("AdaptiveMinStep", 1.0)),
+			  tolerance(conf.GetOr("AdaptiveTolerance", 0.5)) {};
+	};
+
+	// Summary of the endmember posterior at a single timestep
+	template<int Ne>
+	struct PosteriorSummary {
+		double t;
+		MixState<Ne> p025;
+		MixState<Ne> p500;
+		MixState<Ne> p975;
+
+		PosteriorSummary(double T) : t(T) {};
+		PosteriorSummary(double T, const std::vector<MixState<Ne>>& states, size_t skip_records) : t(T) {
+			std::vector<double> tempVec;
+			tempVec.reserve(states.size());
+			for (size_t idx = 0; idx < Ne; ++idx) {
+				tempVec.clear();
+				for (size_t mc = skip_records; mc < states.size(); ++mc) {
+					tempVec.push_back(states[mc][idx]);
+				};
+				p025[idx] = SelectVectorPercentile(tempVec, 2.5);
+				p500[idx] = SelectVectorPercentile(tempVec, 50.0);
+				p975[idx] = SelectVectorPercentile(tempVec, 97.5);
+			};
+		};
 
-		for (double t = TIME_START; t > TIME_END; t -= RES) {
+		// Largest shift in the endmember medians between two timesteps, relative to the mean width of their 95% bands
+		static double Change(const PosteriorSummary& a, const PosteriorSummary& b) {
+			double maxChange = 0.0;
+			for (size_t idx = 0; idx < Ne; ++idx) {
+				double shift = std::abs(a.p500[idx] - b.p500[idx]);
+				double width = 0.5 * ((a.p975[idx] - a.p025[idx]) + (b.p975[idx] - b.p025[idx]));
+				double change = (width > 0.0) ? (shift / width) : ((shift > 0.0) ? INFINITY : 0.0);
+				maxChange = std::max(maxChange, change);
+			};
+			return maxChange;
+		};
+	};
+
+	// Holds the working memory required to run the MCMC for single timesteps of a timeline
+	// Chains draw their random numbers from rng (by default, the global generator)
+	template<int Ne, typename RNG = Random::Global>
+	class TimestepRunner {
+		const ReconManager& RM;
+		RNG rng;
+		std::shared_ptr<const EndmemberTimeline> table;
+		std::shared_ptr<const EndmemberBank> bank;
+		EndmemberState offGrid;
+		size_t Nsys;
+		std::vector<double> gShale;
+		std::vector<double> gShaleErr;
+		std::vector<double> endNmntr;
+		std::vector<double> endDmntr;
+		std::vector<double> endErr;
+		std::vector<MixState<Ne>> mixStates;
+		MixState<Ne> bestFit;
+		double last_report;
+	public:
+		// Runs the MCMC at time t, and registers the result with the results processor
+		// Returns false if this timestep was skipped (due to insufficient data)
+		template<typename RESULTS_PROCESSOR>
+		bool Run(double t, RESULTS_PROCESSOR& results) {
 			//Generate global representative shale at time t, and get its standard error (acquired from the bootstraps)
-			if (!InitShaleData(RM, t, gShale, gShaleErr)) {
-				continue; //If we encountered a NaN value, it means we have no data - so skip this timestep altogether!
+			if (!InitShaleData(RM, t, gShale.data(), gShaleErr.data())) {
+				return false; //If we encountered a NaN value, it means we have no data - so skip this timestep altogether!
 			};
 			//Report progress
-			if (last_report - t > REPORT_FREQ - 0.001) {
+			const double REPORT_FREQ = 100.0;
+			if (std::abs(last_report - t) > REPORT_FREQ - 0.001) {
 				std::cout << "t: " << t << "Ma" << std::endl;
 				last_report = t;
 			};
 
-			//Generate endmembers, and their standard errors
-			InitEndmemberData<Ne>(RM, t, e, endNmntr, endDmntr, endErr);
+			//Look up endmembers, and their standard errors (times off the precomputed grid are recomputed)
+			const EndmemberState* e = table ? table->At(t) : nullptr;
+			if (e == nullptr) {
+				offGrid = RM.RecalculateEndmembers(t);
+				e = &offGrid;
+			};
+			InitEndmemberData<Ne>(RM, *e, endNmntr.data(), endDmntr.data(), endErr.data());
+			//With endmember replicates, the spread of the replicates replaces the analytic endmember errors
+			const double* replicates = bank ? bank->At(t) : nullptr;
+			if (bank && replicates == nullptr) {
+				throw std::runtime_error("No endmember replicates at " + std::to_string(t) + "Ma: the timestep is off the grid of the replicate bank (AdaptiveCoarseStep must be a multiple of AdaptiveMinStep)");
+			};
+			if (replicates != nullptr) {
+				std::fill(endErr.begin(), endErr.end(), 0.0);
+			};
 
 			//Run MCMC 
-			size_t acceptances = MCMC_INNER_LOOP<Ne,
-									&Behaviour::StateGenerator_N<Ne>,
-									&Behaviour::ConstraintsVerifier_N<Ne>>(bestFit, mixStates,
-																		   gShale, gShaleErr,
-																		   endNmntr, endDmntr,
-																		   endErr, Nsys);
+			size_t acceptances = MCMC_INNER_LOOP<Ne, RNG,
+									&Behaviour::StateGenerator_N<Ne, RNG>,
+									&Behaviour::ConstraintsVerifier_N<Ne>>(rng, bestFit, mixStates,
+																		   gShale.data(), gShaleErr.data(),
+																		   endNmntr.data(), endDmntr.data(),
+																		   endErr.data(), Nsys,
+																		   replicates, (replicates != nullptr) ? bank->Replicates() : 0);
 
 #ifdef LOG_MCMC_STATE
 			//DEBUG: Output run of MC!
@@ -200,49 +291,296 @@ namespace MCMCRecon {
 			w.Write("MCMC_OUT_t"+std::to_string(t),mixStates);
 #endif
 			//Register the Earth's state at this time
-			double acceptance_ratio = ((double)acceptances) / ((double)MC_ITER);
-			results.Record(t, bestFit, mixStates, *e, MC_BURN, acceptance_ratio);
+			double acceptance_ratio = ((double)acceptances) / ((double)mixStates.size());
+			results.Record(t, bestFit, mixStates, *e, BurnIn(), acceptance_ratio);
+			return true;
 		};
 
-		delete[] gShale;
-		delete[] gShaleErr;
-		delete[] endNmntr;
-		delete[] endDmntr;
-		delete[] endErr;
-		return results;
+		// Summarises the posterior of the last timestep that was run
+		PosteriorSummary<Ne> Summarise(double t) const {
+			return PosteriorSummary<Ne>(t, mixStates, BurnIn());
+		};
+
+		// Number of initial states of each chain that are discarded
+		size_t BurnIn() const {
+			return mixStates.size() / 5;
+		};
+
+		TimestepRunner(const ReconManager& rm, std::shared_ptr<const EndmemberTimeline> endmembers, std::shared_ptr<const EndmemberBank> endmemberBank,
+					   size_t chainLength = MC_ITER, RNG generator = RNG())
+			: RM(rm), rng(generator), table(endmembers), bank(endmemberBank), Nsys(rm.CountRatios()),
+			gShale(Nsys), gShaleErr(Nsys), endNmntr(Ne * Nsys), endDmntr(Ne * Nsys), endErr(Ne * Nsys),
+			mixStates(chainLength), last_report(INFINITY) {};
 	};
 
-	//Interface functions
-	std::string RunMarkovModel_2M(const ReconManager& RM) {
-		return RunMarkovModel_Impl<2, ResultsProcessor_Endmembers<2>>(RM).Results2CSV();
+	// Recursively bisects the interval between two timesteps, until neighbouring posteriors agree to within
+	// the tolerance, or until the minimum step size is reached.
+	template<int Ne, typename RESULTS_PROCESSOR>
+	void RefineInterval(TimestepRunner<Ne>& runner, RESULTS_PROCESSOR& results, const TimelineSettings& ts,
+						const PosteriorSummary<Ne>& older, const PosteriorSummary<Ne>& younger) {
+		double gap = older.t - younger.t;
+		if (gap <= ts.minRes + 0.001) {
+			return;
+		};
+		if (PosteriorSummary<Ne>::Change(older, younger) <= ts.tolerance) {
+			return;
+		};
+		//Bisect, keeping new timesteps on multiples of the minimum step size
+		double half = std::max(1.0, std::round((gap / 2) / ts.minRes)) * ts.minRes;
+		double t = older.t - half;
+		if (!runner.Run(t, results)) {
+			return;
+		};
+		PosteriorSummary<Ne> mid = runner.Summarise(t);
+		RefineInterval(runner, results, ts, older, mid);
+		RefineInterval(runner, results, ts, mid, younger);
 	};
-	std::string RunMarkovModel_3M(const ReconManager& RM) {
-		return RunMarkovModel_Impl<3, ResultsProcessor_Endmembers<3>>(RM).Results2CSV();
+
+	//Full MCMC timeline reconstruction
+	template<int Ne,
+			typename RESULTS_PROCESSOR>
+	RESULTS_PROCESSOR inline RunMarkovModel_Impl(const ReconManager& RM) {
+		std::cout << "CRUSTAL MCMC REE-CONSTRUCTION INITIATED." << std::endl;
+
+		RESULTS_PROCESSOR results(RM);
+		TimelineSettings ts(RM.GetInitConfig());
+		const double gridStep = ts.adaptive ? ts.minRes : ts.res;
+		TimestepRunner<Ne> runner(RM, RM.GetEndmemberTimeline(ts.timeStart, ts.timeEnd, gridStep), RM.GetEndmemberBank(ts.timeStart, ts.timeEnd, gridStep));
+
+		if (!ts.adaptive) {
+			for (double t = ts.timeStart; t > ts.timeEnd; t -= ts.res) {
+				runner.Run(t, results);
+			};
+		} else {
+			//Run the coarse grid first, then refine between every pair of neighbouring timesteps that both hold data
+			std::vector<PosteriorSummary<Ne>> coarse;
+			std::vector<bool> valid;
+			for (double t = ts.timeStart; t > ts.timeEnd; t -= ts.coarseRes) {
+				bool hasData = runner.Run(t, results);
+				valid.push_back(hasData);
+				coarse.push_back(hasData ? runner.Summarise(t) : PosteriorSummary<Ne>(t));
+			};
+			for (size_t i = 1; i < coarse.size(); ++i) {
+				if (valid[i - 1] && valid[i]) {
+					RefineInterval(runner, results, ts, coarse[i - 1], coarse[i]);
+				};
+			};
+		};
+		return results;
 	};
-	std::string RunMarkovModel_4M(const ReconManager& RM) {
-		return RunMarkovModel_Impl<4, ResultsProcessor_Endmembers<4>>(RM).Results2CSV();
+
+	// Settings for progressive ("anytime") reconstructions
+	struct ProgressiveSettings {
+		double coarseRes;	//Time step of the preview
+		size_t previewIter;	//Chain length of the preview
+		double tolerance;	//Convergence target: largest posterior change (see PosteriorSummary::Change) between passes
+		double timeBudget;	//Maximum run time in seconds (zero for unlimited)
+
+		ProgressiveSettings(const DenseStringMap& conf)
+			: coarseRes(conf.GetOr("ProgressiveCoarseStep", 160.0)), previewIter(conf.GetOr<size_t>("ProgressivePreviewIter", 20000)),
+			  tolerance(conf.GetOr("ProgressiveTolerance", 0.1)), timeBudget(conf.GetOr("ProgressiveTimeBudget", 0.0)) {};
+	};
+
+	// Progressive timeline reconstruction
+	// A coarse preview (short chains on a coarse grid) is computed first. A background thread then repeatedly halves
+	// the time step and quadruples the chain length, re-running every timestep of the current grid, until the
+	// posteriors stop changing between passes, the full resolution & chain length is reached, or the time budget runs out.
+	// Every finished timestep is published immediately, replacing older results for the same time.
+	// Each pass draws from its own Random::Stream (seeded from the global generator in Start), so the background thread
+	// never touches the global generator, and Python may keep using it (e.g. SingleTimestepMCMCR) while refining.
+	template<int Ne,
+			 typename RESULTS_PROCESSOR>
+	class ProgressiveMarkovModel : public ProgressiveRecon {
+		const ReconManager& RM;
+		TimelineSettings ts;
+		ProgressiveSettings ps;
+		RESULTS_PROCESSOR published;
+		//Rows of the published timesteps are buffered in 'pending', and only forwarded to the results sink once publishLock is released
+		std::shared_ptr<ResultsSink> sink;
+		std::shared_ptr<MemoryResultsSink> pending;
+		std::shared_ptr<const EndmemberTimeline> endmembers;
+		std::shared_ptr<const EndmemberBank> endmemberBank;
+		uint64 seed;
+		size_t passes;
+		std::map<double, PosteriorSummary<Ne>> lastSummary;
+		std::chrono::steady_clock::time_point startTime;
+
+		mutable std::mutex publishLock;
+		std::atomic<size_t> version;
+		std::atomic<bool> stopRequested;
+		std::atomic<bool> running;
+		std::thread worker;
+
+		// Forwards records from the timestep runner into the published results
+		struct Publisher {
+			ProgressiveMarkovModel* parent;
+			void Record(double t, const MixState<Ne>& bestFit, const std::vector<MixState<Ne>>& states, const EndmemberState& e, size_t skip_records, double accept_ratio) {
+				{
+					std::lock_guard<std::mutex> guard(parent->publishLock);
+					parent->published.Record(t, bestFit, states, e, skip_records, accept_ratio);
+					++parent->version;
+				};
+				//A Python sink waits for the GIL, whose holder may be waiting for publishLock (in Snapshot)
+				if (parent->sink) {
+					for (const auto& rows : parent->pending->Drain()) {
+						parent->sink->Push(rows.first, rows.second);
+					};
+				};
+			};
+		};
+
+		bool OutOfTime() const {
+			if (ps.timeBudget <= 0.0) {
+				return false;
+			};
+			std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+			return elapsed.count() > ps.timeBudget;
+		};
+
+		// Runs every timestep of a grid with the given step and chain length
+		// Returns the largest change of any posterior with respect to the previous pass, and whether new timesteps were filled in
+		double RunPass(double step, size_t chainLength, bool& filledNew) {
+			TimestepRunner<Ne, Random::Stream> runner(RM, endmembers, endmemberBank, chainLength, Random::Stream(seed, passes++));
+			Publisher pub = {this};
+			double maxChange = 0.0;
+			filledNew = false;
+			for (double t = ts.timeStart; t > ts.timeEnd; t -= step) {
+				if (stopRequested || OutOfTime()) {
+					break;
+				};
+				//Off the table, the runner would recompute the endmembers, which may draw from the global generator
+				if (endmembers->At(t) == nullptr) {
+					throw std::runtime_error("Progressive MCMCR timestep is off the endmember grid!");
+				};
+				if (!runner.Run(t, pub)) {
+					continue;
+				};
+				PosteriorSummary<Ne> summary = runner.Summarise(t);
+				auto it = lastSummary.find(t);
+				if (it != lastSummary.end()) {
+					maxChange = std::max(maxChange, PosteriorSummary<Ne>::Change(it->second, summary));
+					it->second = summary;
+				} else {
+					lastSummary.insert(std::make_pair(t, summary));
+					filledNew = true;
+				};
+			};
+			return maxChange;
+		};
+
+		void Refine(double step, size_t chainLength) {
+			try {
+				while (!(stopRequested || OutOfTime())) {
+					step = std::max(ts.res, step / 2);
+					chainLength = std::min(MC_ITER, chainLength * 4);
+					bool filledNew;
+					double maxChange = RunPass(step, chainLength, filledNew);
+					std::cout << "PROGRESSIVE PASS: STEP " << step << "Myr, CHAIN " << chainLength << ", MAX CHANGE " << maxChange << std::endl;
+					bool fullResolution = (step <= ts.res) && !filledNew;
+					if (fullResolution && ((maxChange < ps.tolerance) || (chainLength >= MC_ITER))) {
+						break;
+					};
+				};
+			} catch (const std::exception& ex) {
+				std::cout << "PROGRESSIVE RECONSTRUCTION FAILED: " << ex.what() << std::endl;
+			};
+			running = false;
+		};
+
+	public:
+		std::string Snapshot() const override {
+			std::unique_lock<std::mutex> guard(publishLock);
+			RESULTS_PROCESSOR copy(published);
+			guard.unlock();
+			return copy.Results2CSV();
+		};
+
+		size_t Version() const override {
+			return version;
+		};
+
+		bool Running() const override {
+			return running;
+		};
+
+		void Stop() override {
+			stopRequested = true;
+			if (worker.joinable()) {
+#ifdef PYTHON_LIB
+				//The worker may be waiting for the GIL (in a Python results sink), so release it while joining
+				if (Py_IsInitialized() && PyGILState_Check()) {
+					Py_BEGIN_ALLOW_THREADS
+					worker.join();
+					Py_END_ALLOW_THREADS
+					return;
+				};
+#endif
+				worker.join();
+			};
+		};
+
+		// Computes the preview on the calling thread, then continues refining in the background
+		void Start() override {
+			startTime = std::chrono::steady_clock::now();
+			seed = Random::Seed();
+			passes = 0;
+			//Every pass lands on the final grid, so one table serves them all
+			endmembers = RM.GetEndmemberTimeline(ts.timeStart, ts.timeEnd, ts.res);
+			endmemberBank = RM.GetEndmemberBank(ts.timeStart, ts.timeEnd, ts.res);
+			//Preview grid is a power-of-two multiple of the final time step, so that every pass lands on the final grid
+			double step = ts.res * std::pow(2.0, std::max(0.0, std::round(std::log2(ps.coarseRes / ts.res))));
+			size_t chainLength = std::min(MC_ITER, ps.previewIter);
+			bool filledNew;
+			RunPass(step, chainLength, filledNew);
+			running = true;
+			worker = std::thread(&ProgressiveMarkovModel::Refine, this, step, chainLength);
+		};
+
+		ProgressiveMarkovModel(const ReconManager& rm) : RM(rm), ts(rm.GetInitConfig()), ps(rm.GetInitConfig()), published(rm),
+			sink(rm.GetResultsSink()), seed(0), passes(0), version(0), stopRequested(false), running(false) {
+			if (sink) {
+				pending = std::make_shared<MemoryResultsSink>();
+				published.StreamTo(pending);
+			};
+		};
+		~ProgressiveMarkovModel() {
+			Stop();
+		};
 	};
-	std::string RunMarkovModel_5M(const ReconManager& RM) {
-		return RunMarkovModel_Impl<5, ResultsProcessor_Endmembers<5>>(RM).Results2CSV();
+
+	//Interface functions
+	ReconOutputs RunMarkovModel_2M(const ReconManager& RM) {
+		return RunMarkovModel_Impl<2, ResultsProcessorSet<2>>(RM).AllResults2Table();
 	};
-	std::string RunMarkovModel_2M_Ratios(const ReconManager& RM) {
-		return RunMarkovModel_Impl<2, ResultsProcessor_Ratios<2>>(RM).Results2CSV();
+	ReconOutputs RunMarkovModel_3M(const ReconManager& RM) {
+		return RunMarkovModel_Impl<3, ResultsProcessorSet<3>>(RM).AllResults2Table();
 	};
-	std::string RunMarkovModel_3M_Ratios(const ReconManager& RM) {
-		return RunMarkovModel_Impl<3, ResultsProcessor_Ratios<3>>(RM).Results2CSV();
+	ReconOutputs RunMarkovModel_4M(const ReconManager& RM) {
+		return RunMarkovModel_Impl<4, ResultsProcessorSet<4>>(RM).AllResults2Table();
 	};
-	std::string RunMarkovModel_4M_Ratios(const ReconManager& RM) {
-		return RunMarkovModel_Impl<4, ResultsProcessor_Ratios<4>>(RM).Results2CSV();
+	ReconOutputs RunMarkovModel_5M(const ReconManager& RM) {
+		return RunMarkovModel_Impl<5, ResultsProcessorSet<5>>(RM).AllResults2Table();
 	};
-	std::string RunMarkovModel_5M_Ratios(const ReconManager& RM) {
-		return RunMarkovModel_Impl<5, ResultsProcessor_Ratios<5>>(RM).Results2CSV();
+
+	ProgressiveRecon* CreateProgressiveMarkovModel(const ReconManager& RM) {
+		switch (RM.GetEndmemberCount()) {
+		case 2:
+			return new ProgressiveMarkovModel<2, ResultsProcessorSet<2>>(RM);
+		case 3:
+			return new ProgressiveMarkovModel<3, ResultsProcessorSet<3>>(RM);
+		case 4:
+			return new ProgressiveMarkovModel<4, ResultsProcessorSet<4>>(RM);
+		case 5:
+			return new ProgressiveMarkovModel<5, ResultsProcessorSet<5>>(RM);
+		default:
+			throw std::runtime_error("Incompatible endmember count for progressive MCMCR!");
+		};
 	};
 
 	//Analyse single time only, output ratio cloud
 	template<int Ne>
 	SingleTimeState SingleTimestepMCMCR(const ReconManager& RM, double t) {
 		size_t Nsys = RM.CountRatios();
-		Endmembers* e = RM.E;
 		double* gShale = new double[Nsys];
 		double* gShaleErr = new double[Nsys];
 		double* endNmntr = new double[Ne * Nsys];
@@ -253,15 +591,21 @@ namespace MCMCRecon {
 
 		//Initialise shale & endmember data
 		InitShaleData(RM, t, gShale, gShaleErr);
-		InitEndmemberData<Ne>(RM, t, e, endNmntr, endDmntr, endErr);
+		InitEndmemberData<Ne>(RM, RM.RecalculateEndmembers(t), endNmntr, endDmntr, endErr);
+		auto bank = RM.GetEndmemberBank(t, t - 1.0, 1.0); //Just this timestep
+		if (bank) {
+			std::fill(endErr, endErr + Ne * Nsys, 0.0);
+		};
 
 		//Run MCMC 
-		MCMC_INNER_LOOP<Ne,
-			&Behaviour::StateGenerator_N<Ne>,
-			&Behaviour::ConstraintsVerifier_N<Ne>>(bestFit, mixStates,
+		Random::Global rng;
+		MCMC_INNER_LOOP<Ne, Random::Global,
+			&Behaviour::StateGenerator_N<Ne, Random::Global>,
+			&Behaviour::ConstraintsVerifier_N<Ne>>(rng, bestFit, mixStates,
 												   gShale, gShaleErr,
 												   endNmntr, endDmntr,
-												   endErr, Nsys);
+												   endErr, Nsys,
+												   bank ? bank->At(t) : nullptr, bank ? bank->Replicates() : 0);
 
 		//Calculate endmember confidence intervals
 		std::vector<double> bestFitState;
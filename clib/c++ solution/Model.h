@@ -7,102 +7,131 @@
 #define EPSILON 0.001
 struct DiscreteFunction {
 	bool finalised;	
-	struct fVal {
-		double x;
-		double y;
-		fVal(double X, double Y) : x(X), y(Y) {};
-		fVal() {};
-		inline bool operator<(const fVal &rhs) const { return x < rhs.x; };
-	};
-	std::vector<fVal> vl;
+	//Datapoints, sorted by x on Finalise (kept as separate arrays so that lookups only touch the x's)
+	std::vector<double> xs;
+	std::vector<double> ys;
+	//Spacing of the x's when Finalise finds them on a uniform grid (zero otherwise), which allows direct indexing
+	double gridStep;
+	double invGridStep;
 	
 	double operator()(double x) const {
 		//Bounds check
-		size_t lastIDX = vl.size() - 1;
-		if (!((x > vl[0].x) && (x < vl[lastIDX].x))) {
+		size_t lastIDX = xs.size() - 1;
+		if (!((x > xs[0]) && (x < xs[lastIDX]))) {
 			//If x lies within epsilon of either end, use the end value
-			if ((x < vl[lastIDX].x) && (x + EPSILON > vl[0].x)) {
-				return vl[0].y;
-			} else if ((x > vl[0].x) && (x - EPSILON < vl[lastIDX].x)) {
-				return vl[lastIDX].y;
+			if ((x < xs[lastIDX]) && (x + EPSILON > xs[0])) {
+				return ys[0];
+			} else if ((x > xs[0]) && (x - EPSILON < xs[lastIDX])) {
+				return ys[lastIDX];
 			} else {
 				//Otherwise, do not extend series outwards based on last datapoint
 				return NAN;
 			};
 		};
+		//Linear interpolation between R & R+1
+		size_t R = Segment(x);
+		//On a datapoint, return it exactly (a NaN neighbour would otherwise leak in through 0*NaN)
+		if (x == xs[R]) {
+			return ys[R];
+		};
+		double f = (x - xs[R]) / (xs[R + 1] - xs[R]);
+		return ys[R] + f*(ys[R + 1] - ys[R]);
+	};
 
-		//Binary search algorithm (since we have a sorted array!)
-		size_t L = 0;
-		size_t R = lastIDX;
-		while (L <= R) {
-			size_t i = (L + R) / 2;
-			if (vl[i].x < x) {
-				L = i + 1;
-			} else if (vl[i].x > x) {
-				R = i - 1;
-			} else {
-				return vl[i].y;
-			};
+	//Evaluates the function at each of the N points in x (same rules as operator())
+	void Evaluate(const double* x, double* out, size_t N) const {
+		for (size_t i = 0; i < N; ++i) {
+			out[i] = operator()(x[i]);
 		};
-		//Linear interpolation between L & R (note: L is now larger than R!)
-		double rangeLR = (vl[L].x - vl[R].x);
-		double f = (x - vl[R].x) / rangeLR;
-		return vl[R].y + f*(vl[L].y - vl[R].y);
+	};
+
+	std::vector<double> Evaluate(const std::vector<double>& x) const {
+		std::vector<double> out(x.size());
+		Evaluate(x.data(), out.data(), x.size());
+		return out;
 	};
 	
 	void AddNewPoint(double x, double y) {
 		finalised= false;
-		vl.push_back(fVal(x,y));
+		gridStep = 0.0;
+		xs.push_back(x);
+		ys.push_back(y);
+	};
+
+	inline size_t Size() const {
+		return xs.size();
+	};
+
+	inline bool IsUniform() const {
+		return gridStep > 0.0;
 	};
 	
 	inline double FirstX() const {
-		return vl.front().x;
+		return xs.front();
 	};
 
 	inline double LastX() const {
-		return vl.back().x;
+		return xs.back();
 	};
 
 	inline double FirstY() const {
-		return vl.front().y;
+		return ys.front();
 	};
 
 	inline double LastY() const {
-		return vl.back().y;
+		return ys.back();
 	};
 
 	void Finalise() {
-		std::sort(vl.begin(),vl.end());
+		if (!std::is_sorted(xs.begin(), xs.end())) {
+			std::vector<size_t> order(xs.size());
+			for (size_t i = 0; i < order.size(); ++i) {
+				order[i] = i;
+			};
+			std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) { return xs[a] < xs[b]; });
+			std::vector<double> X(xs.size()), Y(ys.size());
+			for (size_t i = 0; i < order.size(); ++i) {
+				X[i] = xs[order[i]];
+				Y[i] = ys[order[i]];
+			};
+			xs.swap(X);
+			ys.swap(Y);
+		};
+		//Check for a uniform grid (up to rounding of the x's)
+		gridStep = 0.0;
+		if (xs.size() > 2) {
+			double step = (xs.back() - xs.front()) / (double)(xs.size() - 1);
+			bool uniform = (step > 0.0);
+			for (size_t i = 1; uniform && (i < xs.size()); ++i) {
+				uniform = std::abs(xs[i] - (xs.front() + step * (double)i)) < 1e-9 * step;
+			};
+			if (uniform) {
+				gridStep = step;
+				invGridStep = 1.0 / step;
+			};
+		};
 		finalised= true;
 	};
 	
 	std::vector<double> GenerateXList() const {
-		std::vector<double> rList;
-		for(unsigned int i=0; i<vl.size();++i) {
-			rList.push_back(vl[i].x);
-		};
-		return rList;
+		return xs;
 	};
 	std::vector<double> GenerateYList() const {
-		std::vector<double> rList;
-		for(unsigned int i=0; i<vl.size();++i) {
-			rList.push_back(vl[i].y);
-		};
-		return rList;
+		return ys;
 	};
 	
 	Vect<2>::List GenerateVectList() const {
 		Vect<2>::List rList;
-		for(unsigned int i=0; i<vl.size();++i) {
+		for(unsigned int i=0; i<xs.size();++i) {
 			Vect<2> V;
-			V[0]= vl[i].x;
-			V[1]= vl[i].y;
+			V[0]= xs[i];
+			V[1]= ys[i];
 			rList.push_back(V);
 		};
 		return rList;
 	};
 	
-	DiscreteFunction(size_t suggestedArraySize = 0) : finalised(true) {
+	DiscreteFunction(size_t suggestedArraySize = 0) : finalised(true), gridStep(0.0), invGridStep(0.0) {
 		if (suggestedArraySize > 0) {
 			Reserve(suggestedArraySize);
 		};
@@ -111,8 +140,8 @@ struct DiscreteFunction {
 	void PrintToFile(const std::string& FNAME, const std::string& xname, const std::string& yname) const {
 		std::stringstream ss;
 		ss << xname << "," << yname << std::endl;
-		for (const auto& V : vl) {
-			ss << V.x << "," << V.y << std::endl;
+		for (size_t i = 0; i < xs.size(); ++i) {
+			ss << xs[i] << "," << ys[i] << std::endl;
 		};
 		std::ofstream oFile((DefaultWritePath() + FNAME + ".csv").c_str());
 		oFile << ss.str();
@@ -120,7 +149,24 @@ struct DiscreteFunction {
 	};
 
 	inline void Reserve(size_t SIZE) {
-		vl.reserve(SIZE);
+		xs.reserve(SIZE);
+		ys.reserve(SIZE);
+	};
+
+	//Index R of the interval [xs[R], xs[R+1]] holding an interior point x (xs[R] <= x < xs[R+1])
+	size_t Segment(double x) const {
+		if (IsUniform()) {
+			//Direct indexing, then step past any rounding of the grid
+			size_t R = std::min((size_t)((x - xs[0]) * invGridStep), xs.size() - 2);
+			while ((R > 0) && (xs[R] > x)) {
+				--R;
+			};
+			while (xs[R + 1] <= x) {
+				++R;
+			};
+			return R;
+		};
+		return (size_t)(std::upper_bound(xs.begin(), xs.end(), x) - xs.begin()) - 1;
 	};
 };
 #undef EPSILON
@@ -54,8 +54,8 @@ public:
 			};
 			QIterator& operator++() {
 				++dbIT;
-				while ((predicate->Test(this->operator*()) == false)
-					   &&(dbIT != dbITend)) {
+				while ((dbIT != dbITend)
+					   && (predicate->Test(this->operator*()) == false)) {
 					++dbIT;
 				};
 				return *this;
@@ -109,8 +109,8 @@ public:
 			};
 			QIterator& operator++() {
 				++dbIT;
-				while ((predicate->Test(this->operator*()) == false)
-					   && (dbIT != dbITend)) {
+				while ((dbIT != dbITend)
+					   && (predicate->Test(this->operator*()) == false)) {
 					++dbIT;
 				};
 				return *this;
@@ -162,9 +162,9 @@ public:
 	ETYPE& RandomElement();
 
 	template<typename RET_TYPE>
-	std::vector<RET_TYPE> ExtractList(MemberOffset<ETYPE, RET_TYPE> ofs) {
+	std::vector<RET_TYPE> ExtractList(MemberOffset<ETYPE, RET_TYPE> ofs) const {
 		std::vector<RET_TYPE> retVal;
-		for (IT it = Data().begin(); it != Data().end(); ++it) {
+		for (ITconst it = Data().begin(); it != Data().end(); ++it) {
 			retVal.push_back(ofs.Data(&(*it)));
 		};
 		return retVal;
@@ -9,7 +9,8 @@ RockSample::RockSample()
   Rb(NaN), Sr(NaN), Zr(NaN), Ta(NaN), Hf(NaN), Nb(NaN),  Y(NaN), Ho(NaN), La(NaN), Th(NaN), Ce(NaN), Dy(NaN), Er(NaN),
   Eu(NaN), Gd(NaN), Lu(NaN), Nd(NaN), Pr(NaN), Sm(NaN), Sc(NaN), Tb(NaN), Tm(NaN), Yb(NaN),  U(NaN), Ni(NaN), Co(NaN),
   Cr(NaN), Ba(NaN),  V(NaN), Zn(NaN), Cu(NaN), Pb(NaN), Iron2(NaN), Iron3(NaN), Pt(NaN), Pd(NaN), Tl(NaN),
-  d49Ti(NaN), compositeN(1), Age(NaN), AgeRange(NaN), Intrusive(false), Extrusive(false), RockType(nullptr), RockName(nullptr), Era(nullptr) {};
+  d49Ti(NaN), compositeN(1), Age(NaN), AgeRange(NaN), Intrusive(false), Extrusive(false), RockType(nullptr), RockName(nullptr), Era(nullptr),
+  Lithology(0) {};
 
 RockSample::elementalSuite RockSample::allNumericValues;
 RockSample::elementalSuite RockSample::allIsotopes;
@@ -79,6 +79,10 @@ struct RockSample {
 	Myr				AgeRange;
 	Ratio			d49Ti;
 	unsigned int	compositeN;
+	//LithologyClass bits, zero until classified (ClassifyLithology on a database)
+	//Only valid for the fields at classification time: setting SiO2, MgO, K2O, NaO2 or RockName from Python resets it to zero,
+	//and C++ code that edits these fields afterwards must reclassify.
+	unsigned int	Lithology;
 	
 	double			AppliedWeight;
 
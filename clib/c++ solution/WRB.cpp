@@ -1,9 +1,21 @@
 #include "stdafx.h"
 #include "WRB.h"
 #include "utils.h"
+#include "moduleCommon.h"
+#include <chrono>
 
 //Resolution of all discretised functions
 const size_t RES = 250;
+//Tolerance at the ends of a replicate's age range (as in DiscreteFunction)
+const double EDGE_TOLERANCE = 0.001;
+//Support of the kernel, in kernel widths: beyond it, a kernel weight is below 1e-14 of its peak and is left out
+const double KERNEL_SUPPORT = 8.0;
+//Memory for the replicate values of a round of bootstrap batches, when they are kept for the quantile sketches
+const size_t QUANTILE_ROUND_BYTES = size_t(256) << 20;
+//Bin width of the cross-validation, relative to the narrowest kernel width (see WRB_Kernel for the error of binning)
+const double CV_RELATIVE_BIN_WIDTH = 0.05;
+//Least weight of the neighbours of a sample in the cross-validation, relative to the weight of the sums including it
+const double CV_MIN_WEIGHT = 1e-9;
 
 //Get maximum and minimum values of an array
 inline double ArrMax(size_t N, const double* ARR) noexcept {
@@ -31,170 +43,909 @@ struct Kernel {
 	Kernel(double WIDTH) : s(WIDTH) {};
 };
 
-//Apply weight kernel to all samples, to generate an array of weights
-inline void WeighAll(size_t N, double ageNow, const double* ageArr, double* weights, const Kernel& k) noexcept {
-	for (size_t i = 0; i < N; ++i) {
-		weights[i] = k(ageNow, ageArr[i]);
+// One column of a multi-column bootstrap: a ratio A/B, or an element A (with a unit denominator)
+// Samples where a value is NaN are masked out of this column only (A and B are zero there)
+struct WXB_Column {
+	std::vector<double> A;
+	std::vector<double> B;
+	std::vector<char> valid;
+	double ageMin;
+	double ageMax;
+	size_t count;
+
+	bool InRange(double t) const {
+		return (t + EDGE_TOLERANCE > ageMin) && (t - EDGE_TOLERANCE < ageMax);
+	};
+
+	WXB_Column(size_t N, const double* age, const double* a, const double* b)
+		: A(N, 0.0), B(N, 0.0), valid(N, 0), ageMin(INFINITY), ageMax(-INFINITY), count(0) {
+		for (size_t s = 0; s < N; ++s) {
+			double bs = (b != nullptr) ? b[s] : 1.0;
+			if (std::isfinite(a[s]) && std::isfinite(bs)) {
+				A[s] = a[s];
+				B[s] = bs;
+				valid[s] = 1;
+				ageMin = std::min(ageMin, age[s]);
+				ageMax = std::max(ageMax, age[s]);
+				++count;
+			};
+		};
 	};
 };
 
-// Inner loop for the elemental bootstrap
-// 
-inline double INNER_WEB_POINTCALC(size_t N, const double* W, const double* A, const double* B) {
-	double sumA = 0.0;
-	double sumW = 0.0;
-	for (size_t i = 0; i < N; ++i) {
-		sumA += W[i] * A[i];
-		sumW += W[i];
+// Kernel-matrix bootstrap engine
+// A resample never moves any sample's age, it only changes how many times each sample is counted. The kernel weights
+// K[grid][sample] are therefore computed once, every replicate becomes a vector of multinomial counts C, and a batch of
+// replicates becomes two matrix products, K.(A*C) and K.(B*C), followed by an elementwise division.
+// K is banded: the samples are sorted by age once, and every grid point only keeps the (contiguous) window of samples within
+// the kernel support around it, found by sliding the window along the grid. Its weights are shared by every column.
+class KernelMatrixEngine {
+	size_t G;
+	//Band of grid point j: entries [band[j], band[j + 1]) of 'sample' (sample index, in order of age) & 'K' (kernel weight)
+	std::vector<size_t> band;
+	std::vector<size_t> sample;
+	std::vector<double> K;
+public:
+	//Number of replicates evaluated together
+	static const size_t BATCH = 64;
+
+	//Counts are stored N x BATCH (row-major), results G x BATCH (row-major)
+	//Only the first 'batch' replicate columns are computed
+	void Evaluate(const double* counts, size_t batch, const WXB_Column& col, double* num, double* den) const {
+		for (size_t j = 0; j < G; ++j) {
+			double* numRow = num + j * BATCH;
+			double* denRow = den + j * BATCH;
+			std::fill(numRow, numRow + BATCH, 0.0);
+			std::fill(denRow, denRow + BATCH, 0.0);
+			for (size_t e = band[j]; e < band[j + 1]; ++e) {
+				const size_t s = sample[e];
+				if (!col.valid[s]) {
+					continue;
+				};
+				const double a = K[e] * col.A[s];
+				const double b = K[e] * col.B[s];
+				const double* c = counts + s * BATCH;
+				for (size_t r = 0; r < batch; ++r) {
+					numRow[r] += a * c[r];
+					denRow[r] += b * c[r];
+				};
+			};
+		};
+	};
+
+	//Same as Evaluate, for values that are already weighted by the counts (a & b are stored N x BATCH, like the counts)
+	void EvaluateWeighted(const double* a, const double* b, size_t batch, double* num, double* den) const {
+		for (size_t j = 0; j < G; ++j) {
+			double* numRow = num + j * BATCH;
+			double* denRow = den + j * BATCH;
+			std::fill(numRow, numRow + BATCH, 0.0);
+			std::fill(denRow, denRow + BATCH, 0.0);
+			for (size_t e = band[j]; e < band[j + 1]; ++e) {
+				const double k = K[e];
+				const double* aRow = a + sample[e] * BATCH;
+				const double* bRow = b + sample[e] * BATCH;
+				for (size_t r = 0; r < batch; ++r) {
+					numRow[r] += k * aRow[r];
+					denRow[r] += k * bRow[r];
+				};
+			};
+		};
+	};
+
+	//Best fit & closed-form standard error of the kernel-weighted ratio of sums R = sum(wA)/sum(wB) at every grid point (G values each)
+	//Under multinomial resampling, the delta method gives var(R) = sum(w^2 (A - RB)^2) / sum(wB)^2.
+	void Analytic(const WXB_Column& col, double* fit, double* se) const {
+		for (size_t j = 0; j < G; ++j) {
+			double sA = 0.0, sB = 0.0, sAA = 0.0, sAB = 0.0, sBB = 0.0;
+			for (size_t e = band[j]; e < band[j + 1]; ++e) {
+				const size_t s = sample[e];
+				if (!col.valid[s]) {
+					continue;
+				};
+				const double a = K[e] * col.A[s];
+				const double b = K[e] * col.B[s];
+				sA += a;
+				sB += b;
+				sAA += a * a;
+				sAB += a * b;
+				sBB += b * b;
+			};
+			const double R = sA / sB;
+			fit[j] = R;
+			se[j] = sqrt(std::max(0.0, sAA - 2.0 * R * sAB + R * R * sBB)) / std::abs(sB);
+		};
+	};
+
+	//Same as Analytic, from the sums of A, B, A^2, AB & B^2 of every (binned) sample, moments[0..4] (N values each)
+	void AnalyticSums(const std::vector<double>* moments, double* fit, double* se) const {
+		for (size_t j = 0; j < G; ++j) {
+			double sA = 0.0, sB = 0.0, sAA = 0.0, sAB = 0.0, sBB = 0.0;
+			for (size_t e = band[j]; e < band[j + 1]; ++e) {
+				const size_t s = sample[e];
+				const double k = K[e];
+				const double k2 = k * k;
+				sA += k * moments[0][s];
+				sB += k * moments[1][s];
+				sAA += k2 * moments[2][s];
+				sAB += k2 * moments[3][s];
+				sBB += k2 * moments[4][s];
+			};
+			const double R = sA / sB;
+			fit[j] = R;
+			se[j] = sqrt(std::max(0.0, sAA - 2.0 * R * sAB + R * R * sBB)) / std::abs(sB);
+		};
+	};
+
+	//Mean number of samples per grid point
+	double MeanBandWidth() const {
+		return (G > 0) ? (double)K.size() / (double)G : 0.0;
+	};
+
+	//The grid must be in increasing order; 'support' is in kernel widths (INFINITY keeps every sample)
+	KernelMatrixEngine(const std::vector<double>& grid, size_t N, const double* age, const Kernel& k, double support = KERNEL_SUPPORT)
+		: G(grid.size()), band(G + 1, 0) {
+		std::vector<size_t> order(N);
+		for (size_t s = 0; s < N; ++s) {
+			order[s] = s;
+		};
+		std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return age[a] < age[b]; });
+		const double reach = support * k.s;
+		size_t lo = 0;
+		size_t hi = 0;
+		for (size_t j = 0; j < G; ++j) {
+			while (lo < N && age[order[lo]] < grid[j] - reach) {
+				++lo;
+			};
+			hi = std::max(hi, lo);
+			while (hi < N && age[order[hi]] <= grid[j] + reach) {
+				++hi;
+			};
+			for (size_t n = lo; n < hi; ++n) {
+				sample.push_back(order[n]);
+				K.push_back(k(grid[j], age[order[n]]));
+			};
+			band[j + 1] = K.size();
+		};
 	};
-	return sumA / sumW;
 };
 
-// Inner loop for the ratio bootstrap
-//
-inline double INNER_WRB_POINTCALC(size_t N, const double* W, const double* A, const double* B) {
-	double sumA = 0.0;
-	double sumB = 0.0;
-	for (size_t i = 0; i < N; ++i) {
-		sumA += W[i] * A[i];
-		sumB += W[i] * B[i];
+// Linear binning of the samples onto a regular grid of bin centres, 'binWidth' apart (see WRB_Kernel)
+// Every sample is split between the two bin centres on either side of it, in proportion to its proximity to each;
+// the bins then stand in for the samples in the kernel-matrix engine.
+struct WXB_Binning {
+	std::vector<double> centre;
+	//Lower bin of every sample, and the share of the sample that goes to the bin above it
+	std::vector<size_t> bin;
+	std::vector<double> upper;
+
+	bool Enabled() const { return !centre.empty(); };
+
+	//Sums of the values of a column, weighted by the counts, in every bin (stored M x BATCH, like the counts)
+	//Only the first 'batch' replicate columns are computed
+	void Bin(const double* counts, size_t batch, const WXB_Column& col, double* a, double* b) const {
+		const size_t BATCH = KernelMatrixEngine::BATCH;
+		std::fill(a, a + centre.size() * BATCH, 0.0);
+		std::fill(b, b + centre.size() * BATCH, 0.0);
+		for (size_t s = 0; s < bin.size(); ++s) {
+			if (!col.valid[s]) {
+				continue;
+			};
+			const double* c = counts + s * BATCH;
+			double* aL = a + bin[s] * BATCH;
+			double* bL = b + bin[s] * BATCH;
+			double* aU = aL + BATCH;
+			double* bU = bL + BATCH;
+			const double AU = upper[s] * col.A[s];
+			const double BU = upper[s] * col.B[s];
+			const double AL = col.A[s] - AU;
+			const double BL = col.B[s] - BU;
+			for (size_t r = 0; r < batch; ++r) {
+				aL[r] += AL * c[r];
+				bL[r] += BL * c[r];
+				aU[r] += AU * c[r];
+				bU[r] += BU * c[r];
+			};
+		};
+	};
+
+	//Binned sums of A, B, A^2, AB & B^2 of a column, for KernelMatrixEngine::AnalyticSums
+	void BinMoments(const WXB_Column& col, std::vector<double>* moments) const {
+		for (size_t k = 0; k < 5; ++k) {
+			moments[k].assign(centre.size(), 0.0);
+		};
+		for (size_t s = 0; s < bin.size(); ++s) {
+			if (!col.valid[s]) {
+				continue;
+			};
+			const double a = col.A[s];
+			const double b = col.B[s];
+			const double V[5] = { a, b, a * a, a * b, b * b };
+			for (size_t k = 0; k < 5; ++k) {
+				moments[k][bin[s]] += (1.0 - upper[s]) * V[k];
+				moments[k][bin[s] + 1] += upper[s] * V[k];
+			};
+		};
+	};
+
+	//A bin width of zero (or less) disables binning
+	WXB_Binning(size_t N, const double* age, double binWidth) {
+		if (!(binWidth > 0.0) || N == 0) {
+			return;
+		};
+		const double ageMin = ArrMin(N, age);
+		const size_t M = (size_t)((ArrMax(N, age) - ageMin) / binWidth) + 2;
+		for (size_t m = 0; m < M; ++m) {
+			centre.push_back(ageMin + m * binWidth);
+		};
+		bin.resize(N);
+		upper.resize(N);
+		for (size_t s = 0; s < N; ++s) {
+			double x = (age[s] - ageMin) / binWidth;
+			bin[s] = std::min((size_t)x, M - 2);
+			upper[s] = x - (double)bin[s];
+		};
 	};
-	return sumA / sumB;
 };
 
-//Create best fit for a single draw of samples
-//Implements both the ratio- and elemental- bootstraps
-template<double(*INNER_LOOP)(size_t,const double*,const double*,const double*)>
-inline void WXB_BestFit(DiscreteFunction& f, size_t N, const double* age, double* weights, const double* ValA, const double* ValB, const Kernel& k) noexcept {
-	double ageMax = ArrMax(N, age);
-	double ageMin = ArrMin(N, age);
+//Handle the bootstrapping and results-reporting logic for any number of ratio- and elemental- columns
+//Every replicate draws one resample of all samples, which is shared by all columns; a column only sees its own valid samples.
+//Replicates run in parallel batches on the kernel-matrix engine, each drawing from its own random stream and accumulating its
+//own moments, which are merged in batch order: results are identical for any thread count.
+//Each column is evaluated on the grid points of the shared grid that lie within the age range of its valid samples.
+//In analytic mode, no resamples are drawn (the replicate count and seed are ignored).
+//Every kernel width has its own kernel weights, but shares the resamples; results are ordered by width, then by column.
+//With a positive 'binWidth', the kernel sums run over linearly binned samples instead of the samples themselves (see WRB_Kernel).
+//Kernel weights beyond 'support' kernel widths are left out (INFINITY evaluates the full kernel).
+std::vector<WRB_Result> WXB_Bootstrap(size_t N, const double* Ag, const std::vector<const double*>& Ar, const std::vector<const double*>& Br, const std::vector<double>& kernelWidths, const WRB_Replicates& reps, size_t threads, uint64 seed, WRB_ErrorMode mode, double binWidth = 0.0, double support = KERNEL_SUPPORT) {
+	std::cout << "WRB BOOTSTRAP INIT (" << Ar.size() << " COLUMNS, " << kernelWidths.size() << " KERNEL WIDTHS)" << std::endl;
+	const size_t R = Ar.size();
+	const size_t W = kernelWidths.size();
+	const size_t O = W * R;
+	std::vector<WRB_Result> res(O);
+	if (threads == 0) {
+		threads = Parallel::DefaultThreadCount();
+	};
+	if (N == 0) {
+		return res;
+	};
+	std::vector<WXB_Column> cols;
+	for (size_t i = 0; i < R; ++i) {
+		cols.push_back(WXB_Column(N, Ag, Ar[i], Br[i]));
+	};
+
+	//Shared grid, spanning all samples
+	double ageMax = ArrMax(N, Ag);
+	double ageMin = ArrMin(N, Ag);
 	double ageRng = ageMax - ageMin;
 	double stepSize = ageRng / ((double)RES);
-
-	//Apply kernel function to all samples to create weight
+	std::vector<double> T;
 	for (double t = ageMin; t < ageMax; t += stepSize) {
-		//Use kernel to assign weights
-		WeighAll(N, t, age, weights, k);
-		//Compute and store result
-		double Y = INNER_LOOP(N, weights, ValA, ValB);
-		if (std::isfinite(Y)) {
-			f.AddNewPoint(t, Y);
+		T.push_back(t);
+	};
+	const size_t G = T.size();
+	const size_t BATCH = KernelMatrixEngine::BATCH;
+	//With binning, the engines sum over the M bin centres rather than over the N samples
+	const WXB_Binning binning(N, Ag, binWidth);
+	const bool binned = binning.Enabled();
+	const size_t M = binning.centre.size();
+	std::vector<KernelMatrixEngine> engines;
+	for (double width : kernelWidths) {
+		if (binned) {
+			engines.push_back(KernelMatrixEngine(T, M, binning.centre.data(), Kernel(width), support));
+		} else {
+			engines.push_back(KernelMatrixEngine(T, N, Ag, Kernel(width), support));
 		};
 	};
-	f.Finalise();
-};
+	std::vector<std::vector<double>> num(threads, std::vector<double>(G * BATCH));
+	std::vector<std::vector<double>> den(threads, std::vector<double>(G * BATCH));
+	std::vector<std::vector<double>> binA(threads, std::vector<double>(M * BATCH));
+	std::vector<std::vector<double>> binB(threads, std::vector<double>(M * BATCH));
 
-//Bootstrap sampler for the elemental bootstrap
-void SAMPLER_WEB(size_t N, const double* Ag, const double* Ar, const double* Br,
-				 double* AgB, double* VAB, double* VBB) {
-	//Draw a sample from A values only
-	//(inefficient, lots of unsteady memcpy, but eyh it's probs going to work!)
-	for (size_t s = 0; s < N; ++s) {
-		size_t IDX = Random::Int64(0, N - 1);
-		AgB[s] = Ag[IDX];
-		VAB[s] = Ar[IDX];
+	//Analytic mode: best fit & standard error in a single pass, without resampling
+	if (mode == WRB_ErrorMode::Analytic) {
+		Parallel::For(O, threads, [&](size_t thread, size_t o) {
+			const size_t i = o % R;
+			double* fit = num[thread].data();
+			double* se = den[thread].data();
+			if (binned) {
+				std::vector<double> moments[5];
+				binning.BinMoments(cols[i], moments);
+				engines[o / R].AnalyticSums(moments, fit, se);
+			} else {
+				engines[o / R].Analytic(cols[i], fit, se);
+			};
+			res[o].bestFit.Reserve(RES + 1);
+			res[o].stdError.Reserve(RES + 1);
+			for (size_t j = 0; j < G; ++j) {
+				if (!cols[i].InRange(T[j])) {
+					continue;
+				};
+				if (std::isfinite(fit[j])) {
+					res[o].bestFit.AddNewPoint(T[j], fit[j]);
+				};
+				res[o].stdError.AddNewPoint(T[j], se[j]);
+			};
+			res[o].bestFit.Finalise();
+			res[o].stdError.Finalise();
+		});
+		std::cout << "..ANALYTIC ERRORS COMPUTED" << std::endl;
+		return res;
 	};
-};
 
-//Bootstrap sampler for the ratio bootstrap
-void SAMPLER_WRB(size_t N, const double* Ag, const double* Ar, const double* Br,
-				 double* AgB, double* VAB, double* VBB) {
-	//Draw a sample from both A-values and B-values
-	//(inefficient, lots of unsteady memcpy, but eyh it's probs going to work!)
+	//Best fit: a single "replicate" counting every sample once
+	std::vector<double> ones(N * BATCH, 0.0);
 	for (size_t s = 0; s < N; ++s) {
-		size_t IDX = Random::Int64(0, N - 1);
-		AgB[s] = Ag[IDX];
-		VAB[s] = Ar[IDX];
-		VBB[s] = Br[IDX];
-	};
-};
-
-//Handle the bootstrapping and results-reporting logic for either type of bootstrap
-//Cannot handle NaNs!
-template<double(*INNER_LOOP)(size_t, const double*, const double*,const double*),
-void(*SAMPLER)(size_t,const double*,const double*,const double*,double*,double*,double*)>
-WRB_Result WXB_Bootstrap(size_t N, const double* Ag, const double* Ar, const double* Br, double kernelWidth, size_t ITER) {
-	std::cout << "WRB BOOTSTRAP INIT" << std::endl;
-	const Kernel k(kernelWidth);
-	WRB_Result res;
-	res.bestFit.Reserve(RES + 1);
-	res.stdError.Reserve(RES + 1);
-	
-	//Set up the correct memory arrays and initialise them appropriately,
-	//based on whether we are in ratio mode or not.
-	double* WgB = new double[N];
-	double* AgB = new double[N];
-	double* VAB = new double[N];
-	double* VBB = new double[N];
-	memcpy(AgB, Ag, sizeof(double)*N);
-	memcpy(VAB, Ar, sizeof(double)*N);
-	if (Br != nullptr) {
-		memcpy(VBB, Br, sizeof(double)*N);
-	};
-	std::vector<double> y;
-	y.reserve(ITER);
-
-	//Best fit & bounds computation	
-	double ageMax = ArrMax(N, AgB);
-	double ageMin = ArrMin(N, AgB);
-	WXB_BestFit<INNER_LOOP>(res.bestFit, N, AgB, WgB, VAB, VBB, k);
+		ones[s * BATCH] = 1.0;
+	};
+	Parallel::For(O, threads, [&](size_t thread, size_t o) {
+		const size_t i = o % R;
+		if (binned) {
+			binning.Bin(ones.data(), 1, cols[i], binA[thread].data(), binB[thread].data());
+			engines[o / R].EvaluateWeighted(binA[thread].data(), binB[thread].data(), 1, num[thread].data(), den[thread].data());
+		} else {
+			engines[o / R].Evaluate(ones.data(), 1, cols[i], num[thread].data(), den[thread].data());
+		};
+		res[o].bestFit.Reserve(RES + 1);
+		for (size_t j = 0; j < G; ++j) {
+			double Y = num[thread][j * BATCH] / den[thread][j * BATCH];
+			if (cols[i].InRange(T[j]) && std::isfinite(Y)) {
+				res[o].bestFit.AddNewPoint(T[j], Y);
+			};
+		};
+		res[o].bestFit.Finalise();
+	});
 	std::cout << "..BEST FIT COMPUTED" << std::endl;
 
 	//Confidence interval computation
-	std::vector<DiscreteFunction> fs(ITER, DiscreteFunction(RES + 1));
-	//Draw samples from data, and generate a best fit for each draw
-	size_t lastPrint = 0;
-	size_t printFreq = 250;
-	if (ITER > 1) {
-		for (size_t i = 0; i < ITER; ++i) {
-			SAMPLER(N, Ag, Ar, Br, AgB, VAB, VBB);
-			//Compute best fit of bootstrapped sample
-			WXB_BestFit<INNER_LOOP>(fs[i], N, AgB, WgB, VAB, VBB, k);
+	if (reps.maxIter > 1) {
+		//Replicates are never stored: every batch of a round accumulates the moments of its replicates at each grid point of each
+		//output in a slot of its own, and the slots are merged into the totals in batch order (whichever thread ran them)
+		const size_t ITER = reps.maxIter;
+		const size_t batches = (ITER + BATCH - 1) / BATCH;
+		//With quantile sketches, a slot also keeps the values of its replicates (NaN where there is none), which are streamed into
+		//the single sketch of every grid point of every output in batch order; the round is shortened to keep these in memory
+		const size_t valueCount = reps.quantiles ? O * G * BATCH : 0;
+		size_t ROUND = std::max<size_t>(4, threads);
+		if (valueCount > 0) {
+			ROUND = std::max<size_t>(1, std::min(ROUND, QUANTILE_ROUND_BYTES / (valueCount * sizeof(double))));
+		};
+		std::vector<std::vector<RunningStats>> slots(std::min(ROUND, batches), std::vector<RunningStats>(O * G));
+		std::vector<std::vector<double>> slotValues(std::min(ROUND, batches), std::vector<double>(valueCount));
+		std::vector<RunningStats> stats(O * G);
+		std::vector<QuantileSketch> sketches(reps.quantiles ? O * G : 0);
+		std::vector<std::vector<double>> counts(threads, std::vector<double>(N * BATCH));
+		std::vector<std::vector<double>> rMin(threads, std::vector<double>(R * BATCH));
+		std::vector<std::vector<double>> rMax(threads, std::vector<double>(R * BATCH));
+		//Replicate count of every output: zero while it still runs, set when it stops (converged, or at the last batch)
+		std::vector<size_t> stopped(O, 0);
+		std::atomic<size_t> done(0);
+		std::mutex printLock;
+		auto RUN_BATCH = [&](size_t thread, size_t b, std::vector<RunningStats>& slot, std::vector<double>& values) {
+			size_t i0 = b * BATCH;
+			size_t batch = std::min(BATCH, ITER - i0);
+			double* C = counts[thread].data();
+			//Draw a resample (as counts) for every replicate of the batch
+			std::fill(C, C + N * BATCH, 0.0);
+			for (size_t r = 0; r < batch; ++r) {
+				Random::Stream rng(seed, i0 + r);
+				for (size_t s = 0; s < N; ++s) {
+					size_t IDX = rng.Int64(0, N - 1);
+					C[IDX * BATCH + r] += 1.0;
+				};
+			};
+			for (size_t i = 0; i < R; ++i) {
+				//Outputs which already stopped are left out (their later batches would never be merged)
+				bool running = false;
+				for (size_t w = 0; w < W; ++w) {
+					running |= (stopped[w * R + i] == 0);
+				};
+				if (!running) {
+					continue;
+				};
+				const WXB_Column& col = cols[i];
+				double* lo = &rMin[thread][i * BATCH];
+				double* hi = &rMax[thread][i * BATCH];
+				std::fill(lo, lo + BATCH, INFINITY);
+				std::fill(hi, hi + BATCH, -INFINITY);
+				for (size_t s = 0; s < N; ++s) {
+					if (col.valid[s]) {
+						for (size_t r = 0; r < batch; ++r) {
+							if (C[s * BATCH + r] > 0.0) {
+								lo[r] = std::min(lo[r], Ag[s]);
+								hi[r] = std::max(hi[r], Ag[s]);
+							};
+						};
+					};
+				};
+				if (binned) {
+					binning.Bin(C, batch, col, binA[thread].data(), binB[thread].data());
+				};
+				for (size_t w = 0; w < W; ++w) {
+					if (stopped[w * R + i] != 0) {
+						continue;
+					};
+					if (binned) {
+						engines[w].EvaluateWeighted(binA[thread].data(), binB[thread].data(), batch, num[thread].data(), den[thread].data());
+					} else {
+						engines[w].Evaluate(C, batch, col, num[thread].data(), den[thread].data());
+					};
+					//A replicate is not extended beyond the age range of its own resample
+					RunningStats* acc = &slot[(w * R + i) * G];
+					double* value = reps.quantiles ? &values[(w * R + i) * G * BATCH] : nullptr;
+					for (size_t j = 0; j < G; ++j) {
+						for (size_t r = 0; r < batch; ++r) {
+							if ((T[j] + EDGE_TOLERANCE > lo[r]) && (T[j] - EDGE_TOLERANCE < hi[r])) {
+								double y = num[thread][j * BATCH + r] / den[thread][j * BATCH + r];
+								if (std::isfinite(y)) {
+									acc[j].Add(y);
+									if (value != nullptr) {
+										value[j * BATCH + r] = y;
+									};
+								};
+							};
+						};
+					};
+				};
+			};
 			//Update us on status
-			if (lastPrint + printFreq <= i) {
-				lastPrint = i;
-				std::cout << "   ITER " << i << std::endl;
+			size_t count = (done += batch);
+			if ((count / 250) != ((count - batch) / 250)) {
+				std::lock_guard<std::mutex> guard(printLock);
+				std::cout << "   ITER " << count << std::endl;
 			};
 		};
+		//True once the standard error of an output is precise enough at every grid point
+		auto CONVERGED = [&](size_t o) {
+			for (size_t j = 0; j < G; ++j) {
+				if (cols[o % R].InRange(T[j]) && !(stats[o * G + j].StdDevRelativeError() <= reps.precision)) {
+					return false;
+				};
+			};
+			return true;
+		};
 
-		//Generate best fit and 95% confidence intervals for all points in the age range
-		double ageRng = ageMax - ageMin;
-		double stepSize = ageRng / ((double)RES);
+		//Batches run in rounds, which are merged output by output. An adaptive replicate count checks every output for convergence
+		//after every CHECK_BATCHES batches of its own, and stops it there: where an output stops neither depends on the thread count
+		//(nor on the round size), nor on the other outputs bootstrapped with it.
+		const size_t CHECK_BATCHES = 4;
+		size_t running = O;
+		for (size_t b0 = 0; b0 < batches && running > 0; b0 += ROUND) {
+			size_t b1 = std::min(batches, b0 + ROUND);
+			Parallel::For(b1 - b0, threads, [&](size_t thread, size_t n) {
+				std::fill(slots[n].begin(), slots[n].end(), RunningStats());
+				std::fill(slotValues[n].begin(), slotValues[n].end(), NAN);
+				RUN_BATCH(thread, b0 + n, slots[n], slotValues[n]);
+			});
+			Parallel::For(O, threads, [&](size_t, size_t o) {
+				for (size_t b = b0; b < b1 && stopped[o] == 0; ++b) {
+					for (size_t j = 0; j < G; ++j) {
+						stats[o * G + j].Merge(slots[b - b0][o * G + j]);
+					};
+					if (reps.quantiles) {
+						const double* value = &slotValues[b - b0][o * G * BATCH];
+						for (size_t j = 0; j < G; ++j) {
+							for (size_t r = 0; r < BATCH; ++r) {
+								if (std::isfinite(value[j * BATCH + r])) {
+									sketches[o * G + j].Add(value[j * BATCH + r]);
+								};
+							};
+						};
+					};
+					size_t replicates = std::min(ITER, (b + 1) * BATCH);
+					if (b + 1 == batches) {
+						stopped[o] = replicates;
+					} else if (reps.Adaptive() && ((b + 1) % CHECK_BATCHES == 0) && replicates >= reps.minIter && CONVERGED(o)) {
+						stopped[o] = replicates;
+					};
+				};
+			});
+			running = 0;
+			for (size_t o = 0; o < O; ++o) {
+				running += (stopped[o] == 0);
+			};
+		};
+		if (reps.Adaptive()) {
+			std::cout << "..REPLICATES PER OUTPUT: ";
+			for (size_t o = 0; o < O; ++o) {
+				std::cout << stopped[o] << ((o + 1 < O) ? ", " : "");
+			};
+			std::cout << std::endl;
+		};
+
+		//Generate 95% confidence intervals for all points in the age range of each column
 		std::cout << "..CALC STDEV" << std::endl;
-		for (double t = ageMin; t < ageMax; t += stepSize) {
-			y.clear();
-			for (size_t i = 0; i < ITER; ++i) {
-				double v = fs[i](t);
-				if (std::isfinite(v)) {
-					y.push_back(v);
+		for (size_t o = 0; o < O; ++o) {
+			res[o].stdError.Reserve(RES + 1);
+			for (size_t j = 0; j < G; ++j) {
+				if (!cols[o % R].InRange(T[j])) {
+					continue;
+				};
+				res[o].stdError.AddNewPoint(T[j], stats[o * G + j].SampleStdDev());
+				if (reps.quantiles) {
+					sketches[o * G + j].Shrink();
+					res[o].quantiles.push_back(sketches[o * G + j]);
 				};
 			};
-			res.stdError.AddNewPoint(t, ComputeSampleStdDev(y));
+			res[o].stdError.Finalise();
+			res[o].replicates = stopped[o];
 		};
 		std::cout << "..FINALISE" << std::endl;
-		res.stdError.Finalise();
 	};
-
-	//Clean up temporaries, and return
-	delete[] WgB;
-	delete[] AgB;
-	delete[] VAB;
-	delete[] VBB;
  	return res;
 };
 
-WRB_Result WRB_Bootstrap(const std::vector<double>& age, const std::vector<double>& A, const std::vector<double>& B, double kernelWidth, size_t ITER) {
-	return WXB_Bootstrap<&INNER_WRB_POINTCALC, &SAMPLER_WRB>(age.size(), age.data(), A.data(), B.data(), kernelWidth, ITER);
+//Samples without a valid age take no part in a multi-column bootstrap
+std::vector<WRB_Result> WXB_MultiBootstrap(const std::vector<double>& age, const std::vector<std::vector<double>>& A, const std::vector<std::vector<double>>* B, const std::vector<double>& kernelWidths, double binWidth, const WRB_Replicates& replicates, size_t threads, uint64 seed, WRB_ErrorMode mode) {
+	std::vector<size_t> keep;
+	for (size_t s = 0; s < age.size(); ++s) {
+		if (std::isfinite(age[s])) {
+			keep.push_back(s);
+		};
+	};
+	std::vector<double> ageK(keep.size());
+	std::vector<std::vector<double>> AK(A.size(), std::vector<double>(keep.size()));
+	std::vector<std::vector<double>> BK((B != nullptr) ? B->size() : 0, std::vector<double>(keep.size()));
+	for (size_t n = 0; n < keep.size(); ++n) {
+		ageK[n] = age[keep[n]];
+		for (size_t i = 0; i < AK.size(); ++i) {
+			AK[i][n] = A[i][keep[n]];
+		};
+		for (size_t i = 0; i < BK.size(); ++i) {
+			BK[i][n] = (*B)[i][keep[n]];
+		};
+	};
+	std::vector<const double*> Ar(A.size());
+	std::vector<const double*> Br(A.size(), nullptr);
+	for (size_t i = 0; i < A.size(); ++i) {
+		Ar[i] = AK[i].data();
+		if (B != nullptr) {
+			Br[i] = BK[i].data();
+		};
+	};
+	return WXB_Bootstrap(keep.size(), ageK.data(), Ar, Br, kernelWidths, replicates, threads, seed, mode, binWidth);
+};
+
+WRB_Result WRB_Bootstrap(const std::vector<double>& age, const std::vector<double>& A, const std::vector<double>& B, const WRB_Kernel& kernel, const WRB_Replicates& replicates, size_t threads) {
+	return WRB_Bootstrap(age, A, B, kernel, replicates, threads, Random::Seed());
+};
+
+WRB_Result WRB_Bootstrap(const std::vector<double>& age, const std::vector<double>& A, const std::vector<double>& B, const WRB_Kernel& kernel, const WRB_Replicates& replicates, size_t threads, uint64 seed) {
+	return WXB_Bootstrap(age.size(), age.data(), { A.data() }, { B.data() }, { kernel.width }, replicates, threads, seed, WRB_ErrorMode::Resample, kernel.binWidth).front();
+};
+
+std::vector<WRB_Result> WRB_BandwidthSweep(const std::vector<double>& age, const std::vector<double>& A, const std::vector<double>& B, const std::vector<double>& kernelWidths, const WRB_Replicates& replicates, size_t threads, uint64 seed, WRB_ErrorMode mode, double binWidth) {
+	return WXB_Bootstrap(age.size(), age.data(), { A.data() }, { B.data() }, kernelWidths, replicates, threads, seed, mode, binWidth);
+};
+
+WRB_Result WRB_AnalyticBootstrap(const std::vector<double>& age, const std::vector<double>& A, const std::vector<double>& B, const WRB_Kernel& kernel) {
+	return WXB_Bootstrap(age.size(), age.data(), { A.data() }, { B.data() }, { kernel.width }, 0, 1, 0, WRB_ErrorMode::Analytic, kernel.binWidth).front();
+};
+
+std::vector<WRB_Result> WRB_MultiBootstrap(const std::vector<double>& age, const std::vector<std::vector<double>>& A, const std::vector<std::vector<double>>& B, const WRB_Kernel& kernel, const WRB_Replicates& replicates, size_t threads, uint64 seed, WRB_ErrorMode mode) {
+	return WXB_MultiBootstrap(age, A, &B, { kernel.width }, kernel.binWidth, replicates, threads, seed, mode);
+};
+
+WRB_Result WEB_Bootstrap(const std::vector<double>& age, const std::vector<double>& A, const WRB_Kernel& kernel, const WRB_Replicates& replicates, size_t threads) {
+	return WEB_Bootstrap(age, A, kernel, replicates, threads, Random::Seed());
+};
+
+WRB_Result WEB_Bootstrap(const std::vector<double>& age, const std::vector<double>& A, const WRB_Kernel& kernel, const WRB_Replicates& replicates, size_t threads, uint64 seed) {
+	return WXB_Bootstrap(age.size(), age.data(), { A.data() }, { nullptr }, { kernel.width }, replicates, threads, seed, WRB_ErrorMode::Resample, kernel.binWidth).front();
+};
+
+std::vector<WRB_Result> WEB_MultiBootstrap(const std::vector<double>& age, const std::vector<std::vector<double>>& A, const WRB_Kernel& kernel, const WRB_Replicates& replicates, size_t threads, uint64 seed, WRB_ErrorMode mode) {
+	return WXB_MultiBootstrap(age, A, nullptr, { kernel.width }, kernel.binWidth, replicates, threads, seed, mode);
+};
+
+std::vector<double> WRB_CrossValidation(const std::vector<double>& age, const std::vector<double>& A, const std::vector<double>& B, const std::vector<double>& kernelWidths, size_t threads) {
+	const size_t W = kernelWidths.size();
+	const size_t N = age.size();
+	std::vector<double> score(W, NAN);
+	if (W == 0 || N == 0) {
+		return score;
+	};
+	//Bins of a fraction of the narrowest kernel width, shared by all widths
+	const double h = CV_RELATIVE_BIN_WIDTH * *std::min_element(kernelWidths.begin(), kernelWidths.end());
+	const WXB_Binning binning(N, age.data(), h);
+	const size_t M = binning.centre.size();
+	std::vector<double> binA(M, 0.0), binB(M, 0.0);
+	for (size_t s = 0; s < N; ++s) {
+		binA[binning.bin[s]] += (1.0 - binning.upper[s]) * A[s];
+		binB[binning.bin[s]] += (1.0 - binning.upper[s]) * B[s];
+		binA[binning.bin[s] + 1] += binning.upper[s] * A[s];
+		binB[binning.bin[s] + 1] += binning.upper[s] * B[s];
+	};
+	//Every width is scored on its own, from the kernel sums at all bin centres (the kernel normalisation cancels in the ratio)
+	Parallel::For(W, threads, [&](size_t, size_t w) {
+		const double inv2s2 = 1.0 / (2.0 * kernelWidths[w] * kernelWidths[w]);
+		//Kernel weights of the bin offsets within the kernel support
+		const size_t D = std::min(M - 1, (size_t)(KERNEL_SUPPORT * kernelWidths[w] / h));
+		std::vector<double> k(D + 1);
+		for (size_t d = 0; d <= D; ++d) {
+			k[d] = exp(-(d * h) * (d * h) * inv2s2);
+		};
+		std::vector<double> sA(M, 0.0), sB(M, 0.0);
+		for (size_t m = 0; m < M; ++m) {
+			for (size_t n = (m > D) ? m - D : 0; n <= std::min(M - 1, m + D); ++n) {
+				const double kmn = k[(m > n) ? m - n : n - m];
+				sA[m] += kmn * binA[n];
+				sB[m] += kmn * binB[n];
+			};
+		};
+		//The sums at a sample's age are interpolated between its two bins, like its own share of them; leaving the sample out
+		//subtracts its own binned term, ((1 - u)^2 + u^2) k(0) + 2u(1 - u) k(h), times its A & B
+		RunningStats err;
+		for (size_t s = 0; s < N; ++s) {
+			const size_t m = binning.bin[s];
+			const double u = binning.upper[s];
+			const double own = ((1.0 - u) * (1.0 - u) + u * u) * k[0] + 2.0 * u * (1.0 - u) * ((D > 0) ? k[1] : 0.0);
+			const double fullB = (1.0 - u) * sB[m] + u * sB[m + 1];
+			const double looA = (1.0 - u) * sA[m] + u * sA[m + 1] - own * A[s];
+			const double looB = fullB - own * B[s];
+			//A sample without neighbours in reach has no prediction (its sums are only left with rounding)
+			if (!(std::abs(looB) > CV_MIN_WEIGHT * std::abs(fullB))) {
+				continue;
+			};
+			double e = A[s] - (looA / looB) * B[s];
+			if (std::isfinite(e)) {
+				err.Add(e * e);
+			};
+		};
+		score[w] = (err.n > 0.0) ? err.mean : NAN;
+	});
+	return score;
 };
 
-WRB_Result WEB_Bootstrap(const std::vector<double>& age, const std::vector<double>& A, double kernelWidth, size_t ITER) {
-	return WXB_Bootstrap<&INNER_WEB_POINTCALC, &SAMPLER_WEB>(age.size(), age.data(), A.data(), nullptr, kernelWidth, ITER);
+WRB_Kernel WRB_Kernel::Binned(double width, double relativeBinWidth) {
+	return WRB_Kernel(width, width * relativeBinWidth);
+};
+
+WRB_Replicates WRB_Replicates::Adaptive(double precision, size_t minIter, size_t maxIter) {
+	WRB_Replicates r(maxIter);
+	r.minIter = std::min(minIter, maxIter);
+	r.precision = precision;
+	return r;
+};
+
+DiscreteFunction WRB_Result::PercentileCurve(double percentile) const {
+	DiscreteFunction f;
+	f.Reserve(quantiles.size());
+	for (size_t j = 0; j < quantiles.size(); ++j) {
+		f.AddNewPoint(stdError.xs[j], quantiles[j].Percentile(percentile));
+	};
+	f.Finalise();
+	return f;
+};
+
+//Linear interpolation between the percentiles of the two nearest grid points (same bounds as DiscreteFunction)
+double WRB_Result::PercentileAt(double x, double percentile) const {
+	const auto& X = stdError.xs;
+	if (!((x + EDGE_TOLERANCE > X.front()) && (x - EDGE_TOLERANCE < X.back()))) {
+		return NAN;
+	};
+	if (!(x > X.front())) {
+		return quantiles.front().Percentile(percentile);
+	} else if (!(x < X.back())) {
+		return quantiles.back().Percentile(percentile);
+	};
+	size_t R = stdError.Segment(x);
+	double f = (x - X[R]) / (X[R + 1] - X[R]);
+	double yL = quantiles[R].Percentile(percentile);
+	return yL + f * (quantiles[R + 1].Percentile(percentile) - yL);
 };
 
 double WRB_Result::Percentile975(double x) const {
+	if (!quantiles.empty()) {
+		return PercentileAt(x, 97.5);
+	};
 	return bestFit(x) + 2 * stdError(x);
 };
 
 double WRB_Result::Percentile025(double x) const {
+	if (!quantiles.empty()) {
+		return PercentileAt(x, 2.5);
+	};
 	return bestFit(x) - 2 * stdError(x);
 };
+
+//Benchmark of the banded kernel (KERNEL_SUPPORT) and of binning (bins of a tenth of the kernel width) against the full kernel matrix:
+//bootstraps Th/Sc of the shale database all three ways, for several kernel widths, and reports the run times & the largest
+//differences between the results. The original bootstrap (every replicate weighs all samples at every grid point, with WeighAll
+//& INNER_WRB_POINTCALC) is timed as the baseline; it draws its resamples differently, so only its best fit is compared.
+namespace {
+	REGISTER_MODULE(WRBBenchmark);
+	MODULE_DEPENDENCY(WRBBenchmark, ShaleDB);
+
+	double MaxDifference(const DiscreteFunction& f, const DiscreteFunction& g) {
+		double d = (f.Size() == g.Size()) ? 0.0 : INFINITY;
+		for (size_t j = 0; j < std::min(f.Size(), g.Size()); ++j) {
+			d = std::max(d, std::abs(f.ys[j] - g.ys[j]));
+		};
+		return d;
+	};
+
+	//Apply weight kernel to all samples, to generate an array of weights
+	inline void WeighAll(size_t N, double ageNow, const double* ageArr, double* weights, const Kernel& k) noexcept {
+		for (size_t i = 0; i < N; ++i) {
+			weights[i] = k(ageNow, ageArr[i]);
+		};
+	};
+
+	// Inner loop for the ratio bootstrap
+	inline double INNER_WRB_POINTCALC(size_t N, const double* W, const double* A, const double* B) {
+		double sumA = 0.0;
+		double sumB = 0.0;
+		for (size_t i = 0; i < N; ++i) {
+			sumA += W[i] * A[i];
+			sumB += W[i] * B[i];
+		};
+		return sumA / sumB;
+	};
+
+	//The original ratio bootstrap: every replicate copies out a resample, and weighs all of its samples at every grid point
+	//(over the same grid as WXB_Bootstrap, and spread over the same threads)
+	WRB_Result WeighAllBootstrap(const std::vector<double>& age, const std::vector<double>& A, const std::vector<double>& B, double width, size_t ITER, size_t threads, uint64 seed) {
+		const size_t N = age.size();
+		const Kernel k(width);
+		if (threads == 0) {
+			threads = Parallel::DefaultThreadCount();
+		};
+		double ageMax = ArrMax(N, age.data());
+		double ageMin = ArrMin(N, age.data());
+		double stepSize = (ageMax - ageMin) / ((double)RES);
+		std::vector<double> T;
+		for (double t = ageMin; t < ageMax; t += stepSize) {
+			T.push_back(t);
+		};
+		const size_t G = T.size();
+		WRB_Result res;
+		std::vector<double> weights(N);
+		for (size_t j = 0; j < G; ++j) {
+			WeighAll(N, T[j], age.data(), weights.data(), k);
+			double Y = INNER_WRB_POINTCALC(N, weights.data(), A.data(), B.data());
+			if (std::isfinite(Y)) {
+				res.bestFit.AddNewPoint(T[j], Y);
+			};
+		};
+		res.bestFit.Finalise();
+		//Replicate values, by replicate, then grid point
+		std::vector<double> y(ITER * G);
+		std::vector<std::vector<double>> buffers(threads, std::vector<double>(4 * N));
+		Parallel::For(ITER, threads, [&](size_t thread, size_t i) {
+			double* AgB = buffers[thread].data();
+			double* VAB = AgB + N;
+			double* VBB = VAB + N;
+			double* WgB = VBB + N;
+			Random::Stream rng(seed, i);
+			for (size_t s = 0; s < N; ++s) {
+				size_t IDX = (size_t)rng.Int64(0, N - 1);
+				AgB[s] = age[IDX];
+				VAB[s] = A[IDX];
+				VBB[s] = B[IDX];
+			};
+			for (size_t j = 0; j < G; ++j) {
+				WeighAll(N, T[j], AgB, WgB, k);
+				y[i * G + j] = INNER_WRB_POINTCALC(N, WgB, VAB, VBB);
+			};
+		});
+		for (size_t j = 0; j < G; ++j) {
+			RunningStats stats;
+			for (size_t i = 0; i < ITER; ++i) {
+				if (std::isfinite(y[i * G + j])) {
+					stats.Add(y[i * G + j]);
+				};
+			};
+			res.stdError.AddNewPoint(T[j], stats.SampleStdDev());
+		};
+		res.stdError.Finalise();
+		res.replicates = ITER;
+		return res;
+	};
+
+	void WRBBenchmark::Exec() {
+		const RockDatabase& shales = db("shales");
+		auto ageList = shales.ExtractList(OFF(RockSample::Age));
+		auto AList = shales.ExtractList(OFF(RockSample::Th));
+		auto BList = shales.ExtractList(OFF(RockSample::Sc));
+		std::vector<double> age, A, B;
+		for (size_t s = 0; s < ageList.size(); ++s) {
+			if (std::isfinite(ageList[s]) && std::isfinite(AList[s]) && std::isfinite(BList[s])) {
+				age.push_back(ageList[s]);
+				A.push_back(AList[s]);
+				B.push_back(BList[s]);
+			};
+		};
+		const size_t ITER = 1000;
+		for (double width : { 50.0, 100.0, 200.0, 400.0 }) {
+			std::vector<WRB_Result> r;
+			double seconds[3];
+			auto baselineStart = std::chrono::steady_clock::now();
+			WRB_Result baseline = WeighAllBootstrap(age, A, B, width, ITER, 0, 1);
+			std::chrono::duration<double> baselineElapsed = std::chrono::steady_clock::now() - baselineStart;
+			const double binWidth[3] = { 0.0, 0.0, width / 10.0 };
+			const double support[3] = { INFINITY, KERNEL_SUPPORT, KERNEL_SUPPORT };
+			for (size_t m = 0; m < 3; ++m) {
+				auto startTime = std::chrono::steady_clock::now();
+				r.push_back(WXB_Bootstrap(age.size(), age.data(), { A.data() }, { B.data() }, { width }, ITER, 0, 1, WRB_ErrorMode::Resample, binWidth[m], support[m]).front());
+				std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+				seconds[m] = elapsed.count();
+			};
+			std::cout << "WRB BENCHMARK: " << age.size() << " SAMPLES, WIDTH " << width << ", " << ITER << " REPLICATES" << std::endl;
+			std::cout << "   WEIGHALL      " << baselineElapsed.count() << " s" << std::endl;
+			std::cout << "   FULL KERNEL   " << seconds[0] << " s (x" << baselineElapsed.count() / seconds[0] << ")" << std::endl;
+			std::cout << "   BANDED KERNEL " << seconds[1] << " s (x" << baselineElapsed.count() / seconds[1] << ")" << std::endl;
+			std::cout << "   BINNED KERNEL " << seconds[2] << " s (x" << baselineElapsed.count() / seconds[2] << ")" << std::endl;
+			std::cout << "   MAX DIFFERENCE (FULL KERNEL VS WEIGHALL): BEST FIT " << MaxDifference(baseline.bestFit, r[0].bestFit) << std::endl;
+			std::cout << "   MAX DIFFERENCE (BANDED): BEST FIT " << MaxDifference(r[0].bestFit, r[1].bestFit) << ", STDERR " << MaxDifference(r[0].stdError, r[1].stdError) << std::endl;
+			std::cout << "   MAX DIFFERENCE (BINNED): BEST FIT " << MaxDifference(r[0].bestFit, r[2].bestFit) << ", STDERR " << MaxDifference(r[0].stdError, r[2].stdError)
+				<< " (KERNEL WEIGHT ERROR BOUND " << WRB_Kernel(width, binWidth[2]).BinningErrorBound() << " OF PEAK)" << std::endl;
+		};
+	};
+};
+
+//Check of the binning error bound (see WRB_Kernel) on a synthetic database, for the ratio & elemental best fits:
+//every kernel weight of a binned fit is within BinningErrorBound() * K(0) of the exact one, so at every grid point x, with
+//e = BinningErrorBound() * K(0), R = sum(wA) / sum(wB) may move by at most  e sum|A - R B| / (sum(wB) - e sum|B|)
+//(sums over the samples that either fit gives a weight to). Throws if a binned best fit leaves this bound.
+namespace {
+	REGISTER_MODULE(WRBBinningCheck);
+
+	//Largest ratio of the difference between the exact & binned best fits to its bound, over the grid
+	double BinningErrorRatio(const std::vector<double>& age, const std::vector<double>& A, const std::vector<double>* B, const WRB_Kernel& kernel) {
+		const size_t N = age.size();
+		const double* Bp = (B != nullptr) ? B->data() : nullptr;
+		WRB_Result exact = WXB_Bootstrap(N, age.data(), { A.data() }, { Bp }, { kernel.width }, 0, 1, 0, WRB_ErrorMode::Analytic).front();
+		WRB_Result binned = WXB_Bootstrap(N, age.data(), { A.data() }, { Bp }, { kernel.width }, 0, 1, 0, WRB_ErrorMode::Analytic, kernel.binWidth).front();
+		const Kernel k(kernel.width);
+		const double e = kernel.BinningErrorBound() * k(0.0, 0.0);
+		const double reach = KERNEL_SUPPORT * kernel.width + kernel.binWidth;
+		double worst = 0.0;
+		for (size_t j = 0; j < exact.bestFit.Size(); ++j) {
+			const double x = exact.bestFit.xs[j];
+			const double R = exact.bestFit.ys[j];
+			double sWB = 0.0, sDev = 0.0, sB = 0.0;
+			for (size_t s = 0; s < N; ++s) {
+				if (std::abs(age[s] - x) > reach) {
+					continue;
+				};
+				const double b = (B != nullptr) ? (*B)[s] : 1.0;
+				sWB += k(x, age[s]) * b;
+				sDev += std::abs(A[s] - R * b);
+				sB += std::abs(b);
+			};
+			const double bound = e * sDev / (sWB - e * sB);
+			const double diff = std::abs(binned.bestFit(x) - R);
+			if (!(bound > 0.0) || !(diff <= bound)) {
+				std::cout << "   BINNED BEST FIT OUT OF BOUND AT " << x << ": " << diff << " > " << bound << std::endl;
+				return INFINITY;
+			};
+			worst = std::max(worst, diff / bound);
+		};
+		return worst;
+	};
+
+	void WRBBinningCheck::Exec() {
+		//Ages spread unevenly over 4 Gyr, with values that trend with age
+		const size_t N = 3000;
+		Random::Stream rng(1, 0);
+		std::vector<double> age(N), A(N), B(N);
+		for (size_t s = 0; s < N; ++s) {
+			double u = rng.Double();
+			age[s] = 4000.0 * u * u;
+			B[s] = 1.0 + 20.0 * rng.Double();
+			A[s] = B[s] * (1.0 + age[s] / 1000.0) * (0.5 + rng.Double());
+		};
+		for (double width : { 50.0, 100.0, 200.0, 400.0 }) {
+			for (double relativeBinWidth : { 0.1, 0.25, 0.5 }) {
+				const WRB_Kernel kernel = WRB_Kernel::Binned(width, relativeBinWidth);
+				double ratio = BinningErrorRatio(age, A, &B, kernel);
+				double element = BinningErrorRatio(age, A, nullptr, kernel);
+				std::cout << "WRB BINNING CHECK: WIDTH " << width << ", BIN WIDTH " << kernel.binWidth << ": LARGEST ERROR / BOUND "
+					<< ratio << " (RATIO), " << element << " (ELEMENT)" << std::endl;
+				if (!std::isfinite(ratio) || !std::isfinite(element)) {
+					throw std::runtime_error("WRB binning check failed: a binned best fit is outside the binning error bound");
+				};
+			};
+		};
+	};
+};
@@ -5,13 +5,83 @@
 struct WRB_Result {
 	DiscreteFunction bestFit;
 	DiscreteFunction stdError;
+	//Number of replicates the standard error is based on (zero for analytic errors)
+	size_t replicates = 0;
+	//Quantile sketch of the replicates at every point of stdError (empty for analytic errors, or if not requested)
+	std::vector<QuantileSketch> quantiles;
 
+	//Curve of a percentile (0-100) of the replicates, over the points of stdError (empty without quantile sketches)
+	DiscreteFunction PercentileCurve(double percentile) const;
+	//95% confidence interval: percentiles of the replicates, or bestFit +/- 2 stdError without quantile sketches
 	double Percentile975(double x) const;
 	double Percentile025(double x) const;
+private:
+	double PercentileAt(double x, double percentile) const;
+};
+
+//How WRB_Result::stdError is computed: from ITER resamples, or in a single pass from the closed-form (delta-method) variance
+//of the kernel-weighted ratio of sums, which is much cheaper (e.g. for scans over many ratios)
+enum class WRB_ErrorMode { Resample, Analytic };
+
+//Kernel of a bootstrap: its width, and optionally a bin width (zero for none) for an approximate mode meant for large databases.
+//With binning, every sample is split between the two nearest centres of a regular age grid, 'binWidth' apart (linear binning);
+//the kernel sums then run over these bins, at a cost that no longer grows with the number of samples in reach of the kernel.
+//Error bound: linear binning replaces each sample's kernel weight by its linear interpolation between the two bin centres,
+//which is off by at most (binWidth / width)^2 / 8 of the kernel's peak weight (e.g. 0.125% for binWidth = width / 10).
+struct WRB_Kernel {
+	double width;
+	double binWidth;
+	WRB_Kernel(double WIDTH, double BIN_WIDTH = 0.0) : width(WIDTH), binWidth(BIN_WIDTH) {};
+	//Bins of the given fraction of the kernel width
+	static WRB_Kernel Binned(double width, double relativeBinWidth = 0.1);
+	//Largest error of a kernel weight, relative to the kernel's peak weight (zero without binning)
+	double BinningErrorBound() const { return binWidth * binWidth / (8.0 * width * width); };
+};
+
+//Number of bootstrap replicates: a fixed count, or an adaptive one (precision > 0), where every result stops drawing replicates once the
+//estimated Monte Carlo relative error of its standard error is at most 'precision' at every grid point, within [minIter, maxIter].
+//Convergence is checked every 256 replicates, so that where a result stops only depends on its own replicates.
+//With 'quantiles' (off by default), every grid point also streams its replicates, in order, into a bounded-size quantile sketch
+//(see WRB_Result::PercentileCurve); this costs a sketch per grid point of every result, in memory and in the bootstrap cache.
+struct WRB_Replicates {
+	size_t minIter;
+	size_t maxIter;
+	double precision;
+	bool quantiles = false;
+	bool Adaptive() const { return precision > 0.0; };
+	WRB_Replicates(size_t ITER = 10000) : minIter(ITER), maxIter(ITER), precision(0.0) {};
+	static WRB_Replicates Adaptive(double precision, size_t minIter = 500, size_t maxIter = 20000);
 };
 
 //Generate a ratio bootstrap
-WRB_Result WRB_Bootstrap(const std::vector<double>& age, const std::vector<double>& A, const std::vector<double>& B, double kernelWidth, size_t ITER = 10000);
+//Replicates are spread over 'threads' threads (zero for all hardware threads); results are identical for any thread count.
+//The random streams of the replicates are derived from 'seed' (drawn from the global generator if none is given).
+WRB_Result WRB_Bootstrap(const std::vector<double>& age, const std::vector<double>& A, const std::vector<double>& B, const WRB_Kernel& kernel, const WRB_Replicates& replicates = 10000, size_t threads = 0);
+WRB_Result WRB_Bootstrap(const std::vector<double>& age, const std::vector<double>& A, const std::vector<double>& B, const WRB_Kernel& kernel, const WRB_Replicates& replicates, size_t threads, uint64 seed);
+//Same best fit as WRB_Bootstrap, with the analytic standard error (see WRB_ErrorMode)
+WRB_Result WRB_AnalyticBootstrap(const std::vector<double>& age, const std::vector<double>& A, const std::vector<double>& B, const WRB_Kernel& kernel);
+
+//Generate the ratio bootstrap of A/B for several kernel widths at once, returning one result per width
+//Only the kernel weights depend on the width: every width shares the same resamples, and each result is identical to a
+//WRB_Bootstrap with the same width, bin width & seed.
+std::vector<WRB_Result> WRB_BandwidthSweep(const std::vector<double>& age, const std::vector<double>& A, const std::vector<double>& B, const std::vector<double>& kernelWidths, const WRB_Replicates& replicates, size_t threads, uint64 seed, WRB_ErrorMode mode = WRB_ErrorMode::Resample, double binWidth = 0.0);
+
+//Leave-one-out cross-validation of the kernel-smoothed ratio A/B, for every kernel width in the list
+//Returns the mean of (A - R B)^2 over all samples, where R is the smoothed ratio at the sample's age without the sample itself
+//(the full kernel sums minus the sample's own term); the width with the lowest score predicts best.
+//The kernel sums are computed once per width over linearly binned samples (bins of a twentieth of the narrowest width), which
+//costs a handful of kernel weights per width rather than one per pair of neighbouring samples; the sample's own binned term is
+//subtracted exactly. Widths run in parallel over 'threads' threads (zero for all hardware threads), and scores do not depend on it.
+std::vector<double> WRB_CrossValidation(const std::vector<double>& age, const std::vector<double>& A, const std::vector<double>& B, const std::vector<double>& kernelWidths, size_t threads = 0);
+
+//Generate the ratio bootstraps of several ratios (A[i]/B[i]) together: every resample and the kernel weights are shared by all ratios.
+//NaNs only mask a sample out of the ratios for which it has no data, and every ratio is reported over the age range of its own data.
+//Every ratio's result is the same as when it is bootstrapped alone (on the same ages & seed), with a fixed or an adaptive replicate count.
+std::vector<WRB_Result> WRB_MultiBootstrap(const std::vector<double>& age, const std::vector<std::vector<double>>& A, const std::vector<std::vector<double>>& B, const WRB_Kernel& kernel, const WRB_Replicates& replicates, size_t threads, uint64 seed, WRB_ErrorMode mode = WRB_ErrorMode::Resample);
 
 //Generate an elemental bootstrap
-WRB_Result WEB_Bootstrap(const std::vector<double>& age, const std::vector<double>& A, double kernelWidth, size_t ITER = 10000);
+WRB_Result WEB_Bootstrap(const std::vector<double>& age, const std::vector<double>& A, const WRB_Kernel& kernel, const WRB_Replicates& replicates = 10000, size_t threads = 0);
+WRB_Result WEB_Bootstrap(const std::vector<double>& age, const std::vector<double>& A, const WRB_Kernel& kernel, const WRB_Replicates& replicates, size_t threads, uint64 seed);
+
+//Generate the elemental bootstraps of several elements (A[i]) together, sharing every resample and the kernel weights (see WRB_MultiBootstrap)
+std::vector<WRB_Result> WEB_MultiBootstrap(const std::vector<double>& age, const std::vector<std::vector<double>>& A, const WRB_Kernel& kernel, const WRB_Replicates& replicates, size_t threads, uint64 seed, WRB_ErrorMode mode = WRB_ErrorMode::Resample);
@@ -0,0 +1,170 @@
+#include "stdafx.h"
+#include "WRBCache.h"
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <sys/stat.h>
+#if defined(_UNIXLIKE)
+#include <unistd.h>
+#else
+#include <direct.h>
+#include <process.h>
+#endif
+
+namespace {
+	const char WRB_MAGIC[8] = { 'H', 'L', '3', '8', 'W', 'R', 'B', '3' };
+
+	void WriteFunction(std::ofstream& file, const DiscreteFunction& f) {
+		file.write(reinterpret_cast<const char*>(f.xs.data()), f.Size() * sizeof(double));
+		file.write(reinterpret_cast<const char*>(f.ys.data()), f.Size() * sizeof(double));
+	};
+
+	bool ReadFunction(std::ifstream& file, size_t n, DiscreteFunction& f) {
+		std::vector<double> xy(2 * n);
+		if (!file.read(reinterpret_cast<char*>(xy.data()), xy.size() * sizeof(double))) {
+			return false;
+		};
+		f = DiscreteFunction(n);
+		for (size_t i = 0; i < n; ++i) {
+			f.AddNewPoint(xy[i], xy[n + i]);
+		};
+		f.Finalise();
+		return true;
+	};
+
+	void WriteSketch(std::ofstream& file, const QuantileSketch& q) {
+		std::vector<double> V = q.ToArray();
+		uint64 n = V.size();
+		file.write(reinterpret_cast<const char*>(&n), sizeof(n));
+		file.write(reinterpret_cast<const char*>(V.data()), V.size() * sizeof(double));
+	};
+
+	bool ReadSketch(std::ifstream& file, QuantileSketch& q) {
+		uint64 n;
+		if (!file.read(reinterpret_cast<char*>(&n), sizeof(n)) || n < 3) {
+			return false;
+		};
+		std::vector<double> V((size_t)n);
+		if (!file.read(reinterpret_cast<char*>(V.data()), V.size() * sizeof(double))) {
+			return false;
+		};
+		q = QuantileSketch::FromArray(V.data(), V.size());
+		return true;
+	};
+
+	int CurrentProcessID() {
+#if defined(_UNIXLIKE)
+		return (int)getpid();
+#else
+		return _getpid();
+#endif
+	};
+
+	void MakeDirectory(const std::string& path) {
+#if defined(_UNIXLIKE)
+		mkdir(path.c_str(), 0777);
+#else
+		_mkdir(path.c_str());
+#endif
+	};
+};
+
+void ContentHash::Add(const void* data, size_t bytes) {
+	const unsigned char* p = static_cast<const unsigned char*>(data);
+	for (size_t i = 0; i < bytes; ++i) {
+		h ^= p[i];
+		h *= 1099511628211ULL;
+	};
+};
+
+void ContentHash::Add(const std::string& s) {
+	Add((uint64)s.size());
+	Add(s.data(), s.size());
+};
+
+void ContentHash::Add(const std::vector<double>& V) {
+	Add((uint64)V.size());
+	Add(V.data(), V.size() * sizeof(double));
+};
+
+WRBCache::WRBCache(const std::string& directory) : dir(directory) {
+	if (Enabled()) {
+		if (dir.back() != '/' && dir.back() != '\\') {
+			dir += "/";
+		};
+		MakeDirectory(dir);
+	};
+};
+
+std::string WRBCache::PathFor(uint64 key) const {
+	std::stringstream ss;
+	ss << dir << std::hex << std::setw(16) << std::setfill('0') << key << ".wrb";
+	return ss.str();
+};
+
+bool WRBCache::Load(uint64 key, WRB_Result& r) const {
+	if (!Enabled()) {
+		return false;
+	};
+	std::ifstream file(PathFor(key), std::ios::binary);
+	if (!file) {
+		return false;
+	};
+	char magic[8];
+	uint64 header[5];
+	if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, WRB_MAGIC, sizeof(magic)) != 0) {
+		return false;
+	};
+	if (!file.read(reinterpret_cast<char*>(header), sizeof(header)) || header[0] != key) {
+		return false;
+	};
+	WRB_Result loaded;
+	loaded.replicates = (size_t)header[3];
+	if (!ReadFunction(file, header[1], loaded.bestFit) || !ReadFunction(file, header[2], loaded.stdError)) {
+		return false;
+	};
+	loaded.quantiles.resize((size_t)header[4]);
+	for (auto& q : loaded.quantiles) {
+		if (!ReadSketch(file, q)) {
+			return false;
+		};
+	};
+	r = loaded;
+	return true;
+};
+
+void WRBCache::Store(uint64 key, const WRB_Result& r) const {
+	if (!Enabled()) {
+		return;
+	};
+	std::string path = PathFor(key);
+	std::stringstream tmp;
+	tmp << path << ".tmp" << CurrentProcessID() << "_" << std::hash<std::thread::id>()(std::this_thread::get_id());
+	{
+		std::ofstream file(tmp.str(), std::ios::binary | std::ios::trunc);
+		if (!file) {
+			std::cout << "BOOTSTRAP CACHE: CANNOT WRITE '" << tmp.str() << "'" << std::endl;
+			return;
+		};
+		uint64 header[5] = { key, (uint64)r.bestFit.Size(), (uint64)r.stdError.Size(), (uint64)r.replicates, (uint64)r.quantiles.size() };
+		file.write(WRB_MAGIC, sizeof(WRB_MAGIC));
+		file.write(reinterpret_cast<const char*>(header), sizeof(header));
+		WriteFunction(file, r.bestFit);
+		WriteFunction(file, r.stdError);
+		for (const auto& q : r.quantiles) {
+			WriteSketch(file, q);
+		};
+		//A partial file (e.g. on a full disk) must never be renamed into place
+		bool written = (bool)file;
+		file.close();
+		if (!written || !file) {
+			std::cout << "BOOTSTRAP CACHE: FAILED WRITING '" << tmp.str() << "'" << std::endl;
+			std::remove(tmp.str().c_str());
+			return;
+		};
+	};
+	//If another process got there first (rename fails on Windows), its copy is identical
+	if (std::rename(tmp.str().c_str(), path.c_str()) != 0) {
+		std::remove(tmp.str().c_str());
+	};
+};
@@ -0,0 +1,34 @@
+#pragma once
+#include "WRB.h"
+
+// 64-bit FNV-1a hash of a sequence of values
+class ContentHash {
+	uint64 h = 14695981039346656037ULL;
+public:
+	void Add(const void* data, size_t bytes);
+	void Add(uint64 v) { Add(&v, sizeof(v)); };
+	void Add(double v) { Add(&v, sizeof(v)); };
+	void Add(const std::string& s);
+	void Add(const std::vector<double>& V);
+	uint64 Value() const { return h; };
+};
+
+// Persistent, content-addressed cache of bootstrap results
+// Every result lives in its own file, <directory>/<key>.wrb, where the key hashes everything the bootstrap depends on.
+// File layout: "HL38WRB3", key, best fit point count, standard error point count, replicate count & quantile sketch count (uint64 each),
+// then the x and y arrays of the best fit and of the standard error (float64, native byte order); this fixed part can be memory-mapped.
+// It is followed by every quantile sketch, as its length (uint64) & QuantileSketch::ToArray (float64).
+// Files are written to a temporary name and renamed into place, so processes sharing the directory never see a partial result.
+class WRBCache {
+	std::string dir;
+public:
+	//An empty directory disables the cache
+	WRBCache(const std::string& directory = "");
+	bool Enabled() const { return !dir.empty(); };
+
+	//Returns false on a cache miss (or on an unreadable file)
+	bool Load(uint64 key, WRB_Result& r) const;
+	void Store(uint64 key, const WRB_Result& r) const;
+private:
+	std::string PathFor(uint64 key) const;
+};
@@ -63,3 +63,105 @@ inline double RatioOffset::Access(RockSample * P) { return A.Data(P) / B.Data(P)
 inline double RatioOffset::Access(const RockSample * P) const { return A.Data(P) / B.Data(P); };
 
 RatioOffset::RatioOffset(MemberOffset<RockSample, double> a, MemberOffset<RockSample, double> b) : A(a), B(b) {};
+
+//General mafic endmember
+bool EndmemberM(const RockSample& R) {
+	if (R.Silicate>52)
+		return false;
+	if (R.Silicate<45)
+		return false;
+	if (R.Magnesium>18)
+		return false;
+	return true;
+};
+//General felsic endmember
+bool EndmemberF(const RockSample& R) {
+	if (R.Silicate>80)
+		return false;
+	if (R.Silicate<63)
+		return false;
+	return true;
+};
+//General komatiitic endmember
+bool EndmemberU(const RockSample& R) {
+	if (R.Magnesium < 18) return false;
+	if (R.RockName == nullptr) {
+		return false;
+	};
+	if (R.RockName->find("KOMATIITE [") == std::string::npos) {
+		if ((*R.RockName) != "KOMATIITE") {
+			return false;
+		};
+	};
+	return true;
+};
+
+class TholeiiticLine {
+	DiscreteFunction line;
+public:
+	static const DiscreteFunction& Get() {
+		static TholeiiticLine tl;
+		return tl.line;
+	};
+	TholeiiticLine() {
+		//After Rickwood P.C., Lithos, 1989
+		//TAS tholeiite/calc-alkali division
+		line.AddNewPoint(39.00,  0.0);
+		line.AddNewPoint(41.56,  1.0);
+		line.AddNewPoint(43.28,  2.0);
+		line.AddNewPoint(45.47,  3.0);
+		line.AddNewPoint(48.18,  4.0);
+		line.AddNewPoint(51.02,  5.0);
+		line.AddNewPoint(53.72,  6.0);
+		line.AddNewPoint(56.58,  7.0);
+		line.AddNewPoint(60.47,  8.0);
+		line.AddNewPoint(66.82,  9.0);
+		line.AddNewPoint(77.15, 10.0);
+		line.Finalise();
+	};
+};
+
+//Determine if a mafic rock is on the tholeiitic trend
+bool EndmemberMTT(const RockSample& R) {
+	if (std::isfinite(R.Silicate) && std::isfinite(R.Potassium) && std::isfinite(R.Sodium)) {
+		const DiscreteFunction& line = TholeiiticLine::Get();
+		double s = R.Silicate;
+		double ta = R.Potassium + R.Sodium;
+		if (s < line.FirstX()) {
+			return false;
+		};
+		double pred_max_ta = (s < line.LastX()) ? line(s) : line.LastY();
+
+		return (ta < pred_max_ta);
+	};
+	return false;
+};
+
+//Determine if a mafic rock is non-tholeiitic
+bool EndmemberMNT(const RockSample& R) {
+	if (std::isfinite(R.Silicate) && std::isfinite(R.Potassium) && std::isfinite(R.Sodium)) {
+		return !EndmemberMTT(R);
+	};
+	return false;
+};
+
+unsigned int ClassifyLithology(const RockSample& R) {
+	unsigned int L = LITHO_CLASSIFIED;
+	if (EndmemberU(R)) L |= LITHO_KOMATIITE;
+	if (EndmemberM(R)) L |= LITHO_MAFIC;
+	if (EndmemberF(R)) L |= LITHO_FELSIC;
+	if (EndmemberMTT(R)) L |= LITHO_THOLEIITIC;
+	if (EndmemberMNT(R)) L |= LITHO_NONTHOLEIITIC;
+	return L;
+};
+
+void ClassifyLithology(RockDatabase& db) {
+	for (auto& R : db) {
+		R.Lithology = ClassifyLithology(R);
+	};
+};
+
+bool LithologyFilter::Test(const RockSample& R) const {
+	unsigned int L = (R.Lithology & LITHO_CLASSIFIED) ? R.Lithology : ClassifyLithology(R);
+	return ((L & mask) == mask);
+};
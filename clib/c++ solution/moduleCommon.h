@@ -26,6 +26,34 @@ struct IsGoodish : RockDatabase::Filter {
 	IsGoodish(double TOLERANCE) : tol(TOLERANCE) {};
 };
 
+//Lithologies of the endmember rocks
+bool EndmemberM(const RockSample& R);	//Mafic
+bool EndmemberF(const RockSample& R);	//Felsic
+bool EndmemberU(const RockSample& R);	//Komatiitic
+bool EndmemberMTT(const RockSample& R);	//Tholeiitic trend (of a mafic rock)
+bool EndmemberMNT(const RockSample& R);	//Non-tholeiitic (of a mafic rock)
+
+//The same lithologies, as bits of RockSample::Lithology
+enum LithologyClass : unsigned int {
+	LITHO_MAFIC = 1u << 0,
+	LITHO_FELSIC = 1u << 1,
+	LITHO_KOMATIITE = 1u << 2,
+	LITHO_THOLEIITIC = 1u << 3,
+	LITHO_NONTHOLEIITIC = 1u << 4,
+	LITHO_CLASSIFIED = 1u << 31 //Set once the other bits are valid
+};
+//Runs every lithology predicate on a sample
+unsigned int ClassifyLithology(const RockSample& R);
+//Stores the lithologies of every sample, so that later selections only test bits
+void ClassifyLithology(RockDatabase& db);
+
+//Passes samples of every lithology in the mask (samples which were never classified are classified on the fly)
+struct LithologyFilter : RockDatabase::Filter {
+	unsigned int mask;
+	virtual bool Test(const RockSample & R) const override;
+	LithologyFilter(unsigned int MASK) : mask(MASK) {};
+};
+
 class RatioOffset : public FunctorOffset<RockSample, double> {
 	MemberOffset<RockSample, double> A;
 	MemberOffset<RockSample, double> B;
@@ -1,9 +1,160 @@
 #include "stdafx.h"
 #include "pyLib.h"
 #include "reconManager.h"
+#include <cstring>
 
 //Define common reconstruction-related types that can be passed to the Python interface
 #ifdef PYTHON_LIB
+namespace {
+	//Returns the outputs of every results processor as a {processor name: CSV string} dictionary
+	boost::python::dict RunReconstructionAll(const ReconManager& RM) {
+		boost::python::dict d;
+		for (const auto& out : RM.RunReconstructionAll()) {
+			d[out.first] = out.second.ToCSV();
+		};
+		return d;
+	};
+
+	boost::python::dict Outputs2Dict(const ReconOutputs& outputs) {
+		boost::python::dict d;
+		for (const auto& out : outputs) {
+			d[out.first] = out.second;
+		};
+		return d;
+	};
+
+	//Returns the outputs of every results processor as a {processor name: ResultsTable} dictionary
+	boost::python::dict RunReconstructionTables(const ReconManager& RM) {
+		return Outputs2Dict(RM.RunReconstructionAll());
+	};
+
+	//Setter of a field that ClassifyLithology reads: the stored lithology no longer holds, so it is reset to unclassified
+	template<typename T, T RockSample::* M>
+	void SetLithologyField(RockSample& R, T value) {
+		R.*M = value;
+		R.Lithology = 0;
+	};
+
+	//Bootstraps the ratios A[i]/B[i] together, returns a list of WRB_Results
+	boost::python::list GenerateBootstraps(ReconManager& RM, boost::python::list A, boost::python::list B) {
+		boost::python::list l;
+		for (const auto& r : RM.GenerateBootstraps(PyList2Vect<std::string>(A), PyList2Vect<std::string>(B))) {
+			l.append(r);
+		};
+		return l;
+	};
+
+	//Bootstraps A/B for every kernel width in 'widths', returns a list of WRB_Results
+	boost::python::list GenerateBootstrapSweep(ReconManager& RM, const std::string& A, const std::string& B, boost::python::list widths) {
+		boost::python::list l;
+		for (const auto& r : RM.GenerateBootstrapSweep(A, B, PyList2Vect<double>(widths))) {
+			l.append(r);
+		};
+		return l;
+	};
+
+	ResultsTable CrossValidateKernelWidth(ReconManager& RM, const std::string& A, const std::string& B, boost::python::list widths) {
+		return RM.CrossValidateKernelWidth(A, B, PyList2Vect<double>(widths));
+	};
+
+	double SelectKernelWidth(ReconManager& RM, const std::string& A, const std::string& B, boost::python::list widths) {
+		return RM.SelectKernelWidth(A, B, PyList2Vect<double>(widths));
+	};
+
+	//Evaluates f at every x of a sequence (a list, or a 1-D NumPy array), returns a list
+	boost::python::list EvaluateDiscreteFunction(const DiscreteFunction& f, boost::python::object x) {
+		std::vector<double> X((boost::python::stl_input_iterator<double>(x)), boost::python::stl_input_iterator<double>());
+		boost::python::list l;
+		for (double y : f.Evaluate(X)) {
+			l.append(y);
+		};
+		return l;
+	};
+
+	//A contiguous float64 buffer of a Python object (e.g. a NumPy array), released on destruction
+	struct DoubleBuffer {
+		Py_buffer view;
+		DoubleBuffer(boost::python::object o, bool writable) {
+			int flags = PyBUF_C_CONTIGUOUS | PyBUF_FORMAT | (writable ? PyBUF_WRITABLE : 0);
+			if (PyObject_GetBuffer(o.ptr(), &view, flags) != 0) {
+				boost::python::throw_error_already_set();
+			};
+			if (view.itemsize != sizeof(double) || view.format == NULL || view.format[std::strlen(view.format) - 1] != 'd') {
+				PyBuffer_Release(&view);
+				PyErr_SetString(PyExc_TypeError, "Expected a contiguous float64 array");
+				boost::python::throw_error_already_set();
+			};
+		};
+		~DoubleBuffer() {
+			PyBuffer_Release(&view);
+		};
+		size_t size() const { return (size_t)(view.len / sizeof(double)); };
+		double* data() const { return (double*)view.buf; };
+	};
+
+	//Evaluates f at every x of a float64 array into the array 'out' (of the same size), without copying
+	void EvaluateDiscreteFunctionInto(const DiscreteFunction& f, boost::python::object x, boost::python::object out) {
+		DoubleBuffer X(x, false);
+		DoubleBuffer Y(out, true);
+		if (X.size() != Y.size()) {
+			PyErr_SetString(PyExc_ValueError, "Input and output arrays differ in size");
+			boost::python::throw_error_already_set();
+		};
+		f.Evaluate(X.data(), Y.data(), X.size());
+	};
+
+	//Releases the GIL while it lives: for calls which take a lock that the background thread of a progressive reconstruction
+	//may hold while it waits for the GIL (in a Python results sink)
+	struct AllowThreads {
+		PyThreadState* state;
+		AllowThreads() : state(PyEval_SaveThread()) {};
+		~AllowThreads() {
+			PyEval_RestoreThread(state);
+		};
+	};
+
+	//Returns the timesteps streamed since the last call as a {processor name: ResultsTable} dictionary
+	boost::python::dict DrainStream(ReconManager& RM) {
+		ReconOutputs outputs;
+		{
+			AllowThreads nogil;
+			outputs = RM.DrainStream();
+		};
+		return Outputs2Dict(outputs);
+	};
+
+	std::string GetReconstructionSnapshot(const ReconManager& RM) {
+		AllowThreads nogil;
+		return RM.GetReconstructionSnapshot();
+	};
+
+	size_t GetSnapshotVersion(const ReconManager& RM) {
+		AllowThreads nogil;
+		return RM.GetSnapshotVersion();
+	};
+
+	void StreamToFile(ReconManager& RM, const std::string& pathPrefix) {
+		AllowThreads nogil;
+		RM.StreamToFile(pathPrefix);
+	};
+
+	void StreamToMemory(ReconManager& RM) {
+		AllowThreads nogil;
+		RM.StreamToMemory();
+	};
+
+	void StreamToCallback(ReconManager& RM, boost::python::object callback) {
+		std::shared_ptr<ResultsSink> sink = std::make_shared<PythonResultsSink>(callback);
+		AllowThreads nogil;
+		RM.AddResultsSink(sink);
+	};
+
+	void ClearResultsSinks(ReconManager& RM) {
+		AllowThreads nogil;
+		RM.ClearResultsSinks();
+	};
+};
+
 PYTHON_LINK_EXEC(pyIO_ReconClasses) {
 	using namespace boost::python;
 	class_<MixState<2>>("MixState<2>")
@@ -40,11 +191,12 @@ PYTHON_LINK_EXEC(pyIO_ReconClasses) {
 		.def_readwrite("Era", &RockSample::Era)
 		.def_readwrite("Eu", &RockSample::Eu)
 		.def_readwrite("Gd", &RockSample::Gd)
+		.def_readonly("Lithology", &RockSample::Lithology)
 		.def_readwrite("Hf", &RockSample::Hf)
 		.def_readwrite("Ho", &RockSample::Ho)
 		.def_readwrite("La", &RockSample::La)
 		.def_readwrite("Lu", &RockSample::Lu)
-		.def_readwrite("MgO", &RockSample::Magnesium)
+		.add_property("MgO", make_getter(&RockSample::Magnesium), &SetLithologyField<double, &RockSample::Magnesium>)
 		.def_readwrite("MnO", &RockSample::Manganese)
 		.def_readwrite("Nb", &RockSample::Nb)
 		.def_readwrite("Nd", &RockSample::Nd)
@@ -52,16 +204,16 @@ PYTHON_LINK_EXEC(pyIO_ReconClasses) {
 		.def_readwrite("Pb", &RockSample::Pb)
 		.def_readwrite("Pd", &RockSample::Pd)
 		.def_readwrite("P2O5", &RockSample::Phosphorous)
-		.def_readwrite("K2O", &RockSample::Potassium)
+		.add_property("K2O", make_getter(&RockSample::Potassium), &SetLithologyField<double, &RockSample::Potassium>)
 		.def_readwrite("Pr", &RockSample::Pr)
 		.def_readwrite("Pt", &RockSample::Pt)
 		.def_readwrite("Rb", &RockSample::Rb)
-		.def_readwrite("RockName", &RockSample::RockName)
+		.add_property("RockName", make_getter(&RockSample::RockName), &SetLithologyField<std::string*, &RockSample::RockName>)
 		.def_readwrite("RockType", &RockSample::RockType)
 		.def_readwrite("Sc", &RockSample::Sc)
-		.def_readwrite("SiO2", &RockSample::Silicate)
+		.add_property("SiO2", make_getter(&RockSample::Silicate), &SetLithologyField<double, &RockSample::Silicate>)
 		.def_readwrite("Sm", &RockSample::Sm)
-		.def_readwrite("NaO2", &RockSample::Sodium)
+		.add_property("NaO2", make_getter(&RockSample::Sodium), &SetLithologyField<double, &RockSample::Sodium>)
 		.def_readwrite("Sr", &RockSample::Sr)
 		.def_readwrite("Ta", &RockSample::Ta)
 		.def_readwrite("Tb", &RockSample::Tb)
@@ -79,11 +231,17 @@ PYTHON_LINK_EXEC(pyIO_ReconClasses) {
 	class_<WRB_Result>("WRB_Result")
 		.def_readwrite("bestFit", &WRB_Result::bestFit)
 		.def_readwrite("stdError", &WRB_Result::stdError)
+		.def_readonly("replicates", &WRB_Result::replicates)
+		.def("PercentileCurve", &WRB_Result::PercentileCurve)
 		.def("Percentile975", &WRB_Result::Percentile975)
 		.def("Percentile025", &WRB_Result::Percentile025);
 
 	class_<DiscreteFunction>("DiscreteFunction")
 		.def("__call__", &DiscreteFunction::operator())
+		.def("Evaluate", &EvaluateDiscreteFunction)
+		.def("EvaluateInto", &EvaluateDiscreteFunctionInto)
+		.def("IsUniform", &DiscreteFunction::IsUniform)
+		.def("Size", &DiscreteFunction::Size)
 		.def("GenerateXList", &DiscreteFunction::GenerateXList)
 		.def("GenerateYList", &DiscreteFunction::GenerateYList)
 		.def("AddNewPoint", &DiscreteFunction::AddNewPoint)
@@ -95,13 +253,41 @@ PYTHON_LINK_EXEC(pyIO_ReconClasses) {
 		.def("FirstY", &DiscreteFunction::FirstY)
 		.def("LastY", &DiscreteFunction::LastY);
 
+	class_<ResultsTable>("ResultsTable")
+		.def("ColumnNames", &ResultsTable::ColumnNames)
+		.def("Column", &ResultsTable::ColumnView)
+		.def("Rows", &ResultsTable::Rows)
+		.def("ToCSV", &ResultsTable::ToCSV)
+		.def("WriteBinary", &ResultsTable::WriteBinary)
+		.def("ReadBinary", &ResultsTable::ReadBinary)
+		.staticmethod("ReadBinary");
+
 	class_<ReconManager>("ReconManager", boost::python::init<boost::python::dict, const std::string&>())
 		.def("GenerateAllBootstraps", &ReconManager::GenerateAllBootstraps)
 		.def("ResetAllBootstraps", &ReconManager::ResetAllBootstraps)
 		.def("AddBootstrap", &ReconManager::AddBootstrap)
 		.def("GenerateBootstrap", &ReconManager::GenerateBootstrap)
+		.def("GenerateBootstraps", &GenerateBootstraps)
+		.def("GenerateBootstrapSweep", &GenerateBootstrapSweep)
+		.def("CompareBootstrapErrors", &ReconManager::CompareBootstrapErrors)
+		.def("CompareBinnedBootstrap", &ReconManager::CompareBinnedBootstrap)
+		.def("CrossValidateKernelWidth", &CrossValidateKernelWidth)
+		.def("SelectKernelWidth", &SelectKernelWidth)
 		.def("DataCountForBootstrap", &ReconManager::DataCountForBootstrap)
 		.def("RunReconstruction", &ReconManager::RunReconstruction)
+		.def("RunReconstructionAll", &RunReconstructionAll)
+		.def("RunReconstructionTables", &RunReconstructionTables)
+		.def("RunReconstructionToFiles", &ReconManager::RunReconstructionToFiles)
+		.def("StartProgressiveReconstruction", &ReconManager::StartProgressiveReconstruction)
+		.def("GetReconstructionSnapshot", &GetReconstructionSnapshot)
+		.def("GetSnapshotVersion", &GetSnapshotVersion)
+		.def("IsRefining", &ReconManager::IsRefining)
+		.def("StopProgressiveReconstruction", &ReconManager::StopProgressiveReconstruction)
+		.def("StreamToFile", &StreamToFile)
+		.def("StreamToMemory", &StreamToMemory)
+		.def("StreamToCallback", &StreamToCallback)
+		.def("DrainStream", &DrainStream)
+		.def("ClearResultsSinks", &ClearResultsSinks)
 		.def("GetEndmemberName", &ReconManager::GetEndmemberName)
 		.def("GetEndmemberCount",&ReconManager::GetEndmemberCount)
 		.def("ForwardModelCalc", static_cast<std::vector<double>(ReconManager::*)(double, boost::python::list)const>(&ReconManager::ForwardModelCalc))
@@ -126,8 +312,7 @@ PYTHON_LINK_EXEC(pyIO_ReconClasses) {
 //General Python-exported functions
 namespace {
 	boost::python::dict GetEndmemberRocks(const ReconManager& RM, double t) {
-		RM.E->RecalculateForTime(t);
-		auto e = RM.E->ExportSamples();
+		auto e = RM.ExportEndmemberSamples(t);
 
 		boost::python::dict d;
 		for (size_t i = 0; i < RM.GetEndmemberCount(); ++i) {
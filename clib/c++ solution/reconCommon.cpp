@@ -178,3 +178,248 @@ double ComputeWeightedWeightedErrorSqr(const RockDatabase& db, const MemberOffse
 	double var = (N * sum) / ((N - 1) * sumW * sumW);
 	return var;
 };
+
+WeightedMomentSums::WeightedMomentSums(size_t ratios)
+	: Nel(RockSample::allElements.size()), Nr(ratios), stride(2 * Nel + 6 * Nr) {
+};
+
+void WeightedMomentSums::Finalise(const Window& w, RockSample& rock, std::vector<double>& errR) const {
+	for (size_t e = 0; e < Nel; ++e) {
+		RockSample::allElements.at(e).second.DataR(rock) = w[2 * e] / w[2 * e + 1];
+	};
+	//Cochran's estimator, with its sum expanded as sum((X - Xbar * W)^2) = Sxx - 2 * Xbar * Sxw + Xbar^2 * Sww
+	errR.clear();
+	for (size_t r = 0; r < Nr; ++r) {
+		const double* m = &w[2 * Nel + 6 * r];
+		double N = m[0];
+		double Xbar = m[1] / m[2];
+		double sum = std::max(m[3] - 2 * Xbar * m[5] + Xbar * Xbar * m[4], 0.0);
+		double var = (N * sum) / ((N - 1) * m[2] * m[2]);
+		errR.push_back(sqrt(var));
+	};
+};
+
+AgePrefixSums::AgePrefixSums(const RockDatabase& db, const std::vector<MemberOffset<RockSample, double>>& A, const std::vector<MemberOffset<RockSample, double>>& B)
+	: WeightedMomentSums(A.size()) {
+	//Same cut as ComputeWeightedWeightedErrorSqr, though taken before any window scales the weights
+	const double EPSILON = 0.00000001;
+	std::vector<const RockSample*> sorted;
+	for (const RockSample& R : db) {
+		if (std::isfinite(R.Age)) {
+			sorted.push_back(&R);
+		};
+	};
+	std::stable_sort(sorted.begin(), sorted.end(), [](const RockSample* a, const RockSample* b) { return a->Age < b->Age; });
+
+	age.resize(sorted.size());
+	sums.assign((sorted.size() + 1) * stride, 0.0);
+	for (size_t k = 0; k < sorted.size(); ++k) {
+		const RockSample& R = *sorted[k];
+		age[k] = R.Age;
+		const double* prev = &sums[k * stride];
+		double* row = &sums[(k + 1) * stride];
+		std::copy(prev, prev + stride, row);
+		//Elements: weighted value, weight
+		for (size_t e = 0; e < Nel; ++e) {
+			double VAL = RockSample::allElements.at(e).second.Data(R);
+			if (std::isfinite(VAL)) {
+				row[2 * e] += R.AppliedWeight * VAL;
+				row[2 * e + 1] += R.AppliedWeight;
+			};
+		};
+		//Ratios: count, sums of X, W, X^2, W^2, XW (X = nominator, W = weight * denominator)
+		for (size_t r = 0; r < Nr; ++r) {
+			double X = A[r](R);
+			double W = R.AppliedWeight * B[r](R);
+			if (std::isfinite(X) && std::isfinite(W) && W > EPSILON) {
+				double* m = row + 2 * Nel + 6 * r;
+				m[0] += 1.0;
+				m[1] += X;
+				m[2] += W;
+				m[3] += X * X;
+				m[4] += W * W;
+				m[5] += X * W;
+			};
+		};
+	};
+};
+
+void AgePrefixSums::Add(Window& w, double from, double to, bool includeTo, double weightScale) const {
+	size_t lo = std::lower_bound(age.begin(), age.end(), from) - age.begin();
+	size_t hi = (includeTo ? std::upper_bound(age.begin(), age.end(), to) : std::lower_bound(age.begin(), age.end(), to)) - age.begin();
+	if (hi <= lo) {
+		return;
+	};
+	const double* L = &sums[lo * stride];
+	const double* H = &sums[hi * stride];
+	for (size_t e = 0; e < 2 * Nel; ++e) {
+		w[e] += weightScale * (H[e] - L[e]);
+	};
+	//Only the weights scale; the nominators do not
+	const double scale[6] = { 1.0, 1.0, weightScale, 1.0, weightScale * weightScale, weightScale };
+	for (size_t j = 2 * Nel; j < stride; ++j) {
+		w[j] += scale[(j - 2 * Nel) % 6] * (H[j] - L[j]);
+	};
+};
+
+KernelTimeline::KernelTimeline(const RockDatabase& db, const std::vector<MemberOffset<RockSample, double>>& A, const std::vector<MemberOffset<RockSample, double>>& B, double width)
+	: WeightedMomentSums(A.size()), tMin(0.0), step(0.0) {
+	//Same cut as ComputeWeightedWeightedErrorSqr
+	const double EPSILON = 0.00000001;
+	double minAge = INFINITY;
+	double maxAge = -INFINITY;
+	for (const RockSample& R : db) {
+		if (std::isfinite(R.Age)) {
+			minAge = std::min(minAge, R.Age);
+			maxAge = std::max(maxAge, R.Age);
+		};
+	};
+	if (!(minAge <= maxAge) || !(width > 0.0)) {
+		return;
+	};
+	//A round step, so that round timesteps fall on the grid
+	double target = width / 20.0;
+	double decade = pow(10.0, floor(log10(target)));
+	for (double m : { 5.0, 2.5, 2.0, 1.0 }) {
+		if (m * decade <= target) {
+			step = m * decade;
+			break;
+		};
+	};
+	tMin = floor(minAge / step) * step;
+	const size_t G = std::max((size_t)ceil((maxAge - tMin) / step), (size_t)1) + 1;
+
+	//Bin the samples onto the grid (linearly, between the two nearest grid points):
+	//per element, sums of value & count; per ratio, sums of B, B^2 & AB
+	const size_t binStride = 2 * Nel + 3 * Nr;
+	std::vector<double> bins(G * binStride, 0.0);
+	//Per ratio, the times between which each sample passes the cut, with its A
+	std::vector<std::vector<std::pair<double, double>>> starts(Nr), ends(Nr);
+	present.assign(Nel, 0);
+	const double peak = expKernel(0.0, width);
+	for (const RockSample& R : db) {
+		if (!std::isfinite(R.Age)) {
+			continue;
+		};
+		double u = (R.Age - tMin) / step;
+		size_t g = std::min((size_t)u, G - 2);
+		double f = std::min(u - (double)g, 1.0);
+		double* b0 = &bins[g * binStride];
+		double* b1 = b0 + binStride;
+		for (size_t e = 0; e < Nel; ++e) {
+			double VAL = RockSample::allElements.at(e).second.Data(R);
+			if (std::isfinite(VAL)) {
+				present[e] = 1;
+				b0[2 * e] += (1 - f) * VAL;
+				b0[2 * e + 1] += (1 - f);
+				b1[2 * e] += f * VAL;
+				b1[2 * e + 1] += f;
+			};
+		};
+		for (size_t r = 0; r < Nr; ++r) {
+			double X = A[r](R);
+			double Y = B[r](R);
+			//The sample passes the cut while expKernel(age - t) * Y > EPSILON, i.e. for |age - t| < reach
+			if (!(std::isfinite(X) && std::isfinite(Y) && (peak * Y > EPSILON))) {
+				continue;
+			};
+			double reach = width * sqrt(2 * log(peak * Y / EPSILON));
+			double* c0 = b0 + 2 * Nel + 3 * r;
+			double* c1 = b1 + 2 * Nel + 3 * r;
+			const double m[3] = { Y, Y * Y, X * Y };
+			for (size_t k = 0; k < 3; ++k) {
+				c0[k] += (1 - f) * m[k];
+				c1[k] += f * m[k];
+			};
+			starts[r].push_back(std::make_pair(R.Age - reach, X));
+			ends[r].push_back(std::make_pair(R.Age + reach, X));
+		};
+	};
+
+	//Convolve the bins with the kernel (and its square, for the W^2 sums), up to 8 widths away
+	const size_t D = std::min((size_t)ceil(8.0 * width / step), G - 1);
+	std::vector<double> K(D + 1);
+	std::vector<double> K2(D + 1);
+	for (size_t d = 0; d <= D; ++d) {
+		K[d] = expKernel((double)d * step, width);
+		K2[d] = K[d] * K[d];
+	};
+	rows.assign(G * stride, 0.0);
+	for (size_t g = 0; g < G; ++g) {
+		double* row = &rows[g * stride];
+		size_t first = (g > D) ? g - D : 0;
+		size_t last = std::min(g + D, G - 1);
+		for (size_t h = first; h <= last; ++h) {
+			const size_t d = (h > g) ? h - g : g - h;
+			const double k = K[d];
+			const double k2 = K2[d];
+			const double* b = &bins[h * binStride];
+			for (size_t e = 0; e < 2 * Nel; ++e) {
+				row[e] += k * b[e];
+			};
+			for (size_t r = 0; r < Nr; ++r) {
+				double* m = row + 2 * Nel + 6 * r;
+				const double* c = b + 2 * Nel + 3 * r;
+				m[2] += k * c[0];
+				m[4] += k2 * c[1];
+				m[5] += k * c[2];
+			};
+		};
+	};
+
+	//Running count, sum of A & sum of A^2 over the samples sorted by start & by end of their time within the cut
+	reach.resize(Nr);
+	for (size_t r = 0; r < Nr; ++r) {
+		std::sort(starts[r].begin(), starts[r].end());
+		std::sort(ends[r].begin(), ends[r].end());
+		reach[r].Init(starts[r], reach[r].start, reach[r].startSums);
+		reach[r].Init(ends[r], reach[r].end, reach[r].endSums);
+	};
+};
+
+void KernelTimeline::Reach::Init(const std::vector<std::pair<double, double>>& events, std::vector<double>& T, std::vector<double>& sums) {
+	T.resize(events.size());
+	sums.assign(3 * (events.size() + 1), 0.0);
+	for (size_t k = 0; k < events.size(); ++k) {
+		T[k] = events[k].first;
+		double X = events[k].second;
+		sums[3 * (k + 1)] = sums[3 * k] + 1.0;
+		sums[3 * (k + 1) + 1] = sums[3 * k + 1] + X;
+		sums[3 * (k + 1) + 2] = sums[3 * k + 2] + X * X;
+	};
+};
+
+bool KernelTimeline::Lookup(double t, Window& w) const {
+	if (rows.empty()) {
+		return false;
+	};
+	const size_t G = rows.size() / stride;
+	double u = (t - tMin) / step;
+	if (!((u >= 0.0) && (u <= (double)(G - 1)))) {
+		return false;
+	};
+	size_t g = std::min((size_t)u, G - 2);
+	double f = u - (double)g;
+	const double* r0 = &rows[g * stride];
+	const double* r1 = r0 + stride;
+	w.resize(stride);
+	for (size_t j = 0; j < stride; ++j) {
+		w[j] = (1 - f) * r0[j] + f * r1[j];
+	};
+	//The samples passing the cut at t are those started before t, less those ended by t
+	for (size_t r = 0; r < Nr; ++r) {
+		const Reach& R = reach[r];
+		size_t s = std::lower_bound(R.start.begin(), R.start.end(), t) - R.start.begin();
+		size_t e = std::upper_bound(R.end.begin(), R.end.end(), t) - R.end.begin();
+		double* m = &w[2 * Nel + 6 * r];
+		m[0] = R.startSums[3 * s] - R.endSums[3 * e];
+		m[1] = R.startSums[3 * s + 1] - R.endSums[3 * e + 1];
+		m[3] = R.startSums[3 * s + 2] - R.endSums[3 * e + 2];
+	};
+	for (size_t e = 0; e < Nel; ++e) {
+		if (present[e] && !(w[2 * e + 1] > 0.0)) {
+			return false;
+		};
+	};
+	return true;
+};
@@ -73,6 +73,71 @@ double ComputeWeightedErrorSqr(const RockDatabase& db, const MemberOffset<RockSa
 
 double ComputeWeightedWeightedErrorSqr(const RockDatabase& db, const MemberOffset<RockSample, double>& A, const MemberOffset<RockSample, double>& B);
 
+// Gaussian kernel of width s, as used to weight samples by their age difference
+inline double expKernel(double deltaX, double s) noexcept {
+	return (1.0 / (sqrt(2 * M_PI)*s))*exp(-(deltaX*deltaX) / (2 * s*s));
+};
+
+// Sums over a set of weighted samples: per element, of the weight & weighted value; per ratio, the count and the
+// sums of X, W, X^2, W^2 & XW behind ComputeWeightedWeightedErrorSqr (X = nominator, W = weight * denominator).
+// The weighted mean rock & ratio errors follow from these alone.
+class WeightedMomentSums {
+protected:
+	size_t Nel;
+	size_t Nr;
+	size_t stride;
+	WeightedMomentSums(size_t ratios);
+public:
+	typedef std::vector<double> Window;
+	inline size_t Ratios() const { return Nr; };
+	inline Window NewWindow() const { return Window(stride, 0.0); };
+	//Weighted mean rock & ratio errors (as Endmembers::CalculateWeightedMeanAndRatioErrorsForDB) of the samples in w
+	void Finalise(const Window& w, RockSample& rock, std::vector<double>& errR) const;
+};
+
+// Running sums over the samples of a database sorted by age, from which the sums of any age window follow from
+// two rows, without copying or rescanning the samples.
+class AgePrefixSums : public WeightedMomentSums {
+	std::vector<double> age; //Sample ages, sorted
+	std::vector<double> sums; //Row k holds the sums over the k youngest samples
+public:
+	AgePrefixSums() : WeightedMomentSums(0) {};
+	AgePrefixSums(const RockDatabase& db, const std::vector<MemberOffset<RockSample, double>>& A, const std::vector<MemberOffset<RockSample, double>>& B);
+	inline bool Empty() const { return sums.empty(); };
+
+	//Adds the samples aged within [from, to] (or [from, to) if 'includeTo' is false) to w, with their applied weights scaled by 'weightScale'
+	void Add(Window& w, double from, double to, bool includeTo = true, double weightScale = 1.0) const;
+};
+
+// The sums at every time t of a grid over the ages of a database, with each sample weighted by expKernel(age - t, width)
+// in place of its applied weight. Built at once by binning the samples by age & convolving the bins with the kernel,
+// so that the kernel weights are within (step / width)^2 / 8 of the peak; the samples dropped by the cut on small
+// weights in ComputeWeightedWeightedErrorSqr are tracked exactly, at any time.
+class KernelTimeline : public WeightedMomentSums {
+	double tMin;
+	double step; //About a twentieth of the kernel width, rounded down to 1, 2, 2.5 or 5 times a power of ten
+	std::vector<double> rows; //Row g holds the kernel-weighted sums at t = tMin + g * step
+	std::vector<char> present; //Per element, whether any sample has a value
+	//Per ratio, the start & end times of each sample's pass through the cut on small weights (sorted), with
+	//running counts, sums of X & sums of X^2 in either order
+	struct Reach {
+		std::vector<double> start;
+		std::vector<double> end;
+		std::vector<double> startSums;
+		std::vector<double> endSums;
+		static void Init(const std::vector<std::pair<double, double>>& events, std::vector<double>& T, std::vector<double>& sums);
+	};
+	std::vector<Reach> reach;
+public:
+	KernelTimeline() : WeightedMomentSums(0), tMin(0.0), step(0.0) {};
+	KernelTimeline(const RockDatabase& db, const std::vector<MemberOffset<RockSample, double>>& A, const std::vector<MemberOffset<RockSample, double>>& B, double width);
+	inline bool Empty() const { return rows.empty(); };
+
+	//Sums at time t, interpolated between the two nearest grid times; false if t lies outside the grid, or if no
+	//sample of an element lies within reach of the (truncated) kernel
+	bool Lookup(double t, Window& w) const;
+};
+
 
 // Structure to store detailed results from the MCMC run of a single timestep.
 //
@@ -138,6 +203,12 @@ public:
 	void Insert(const std::string& key, const std::string& val);
 	void Insert(const std::string& key, std::initializer_list<std::string> V);
 
+	//Returns the first value stored under key, or DEFAULT_VAL if the key is not present
+	template<typename T>
+	T GetOr(const std::string& key, T DEFAULT_VAL) const {
+		return Contains(key) ? StringToData<T>(Get(key)) : DEFAULT_VAL;
+	};
+
 #ifdef PYTHON_LIB
 	DenseStringMap(const boost::python::dict& D);
 #endif
@@ -1,88 +1,7 @@
 #include "stdafx.h"
 #include "reconEndmembers.h"
 
-//General mafic endmember
-bool EndmemberM(const RockSample& R) {
-	if (R.Silicate>52)
-		return false;
-	if (R.Silicate<45)
-		return false;
-	if (R.Magnesium>18)
-		return false;
-	return true;
-};
-//General felsic endmember
-bool EndmemberF(const RockSample& R) {
-	if (R.Silicate>80)
-		return false;
-	if (R.Silicate<63)
-		return false;
-	return true;
-};
-//General komatiitic endmember
-bool EndmemberU(const RockSample& R) {
-	if (R.Magnesium < 18) return false;
-	if (R.RockName == nullptr) {
-		return false;
-	};
-	if (R.RockName->find("KOMATIITE [") == std::string::npos) {
-		if ((*R.RockName) != "KOMATIITE") {
-			return false;
-		};
-	};
-	return true;
-};
-
-class TholeiiticLine {
-	DiscreteFunction line;
-public:
-	static const DiscreteFunction& Get() {
-		static TholeiiticLine tl;
-		return tl.line;
-	};
-	TholeiiticLine() {
-		//After Rickwood P.C., Lithos, 1989
-		//TAS tholeiite/calc-alkali division
-		line.AddNewPoint(39.00,  0.0);
-		line.AddNewPoint(41.56,  1.0);
-		line.AddNewPoint(43.28,  2.0);
-		line.AddNewPoint(45.47,  3.0);
-		line.AddNewPoint(48.18,  4.0);
-		line.AddNewPoint(51.02,  5.0);
-		line.AddNewPoint(53.72,  6.0);
-		line.AddNewPoint(56.58,  7.0);
-		line.AddNewPoint(60.47,  8.0);
-		line.AddNewPoint(66.82,  9.0);
-		line.AddNewPoint(77.15, 10.0);
-		line.Finalise();
-	};
-};
-
-//Determine if a mafic rock is on the tholeiitic trend
-bool EndmemberMTT(const RockSample& R) {
-	if (std::isfinite(R.Silicate) && std::isfinite(R.Potassium) && std::isfinite(R.Sodium)) {
-		const DiscreteFunction& line = TholeiiticLine::Get();
-		double s = R.Silicate;
-		double ta = R.Potassium + R.Sodium;
-		if (s < line.FirstX()) {
-			return false;
-		};
-		double pred_max_ta = (s < line.LastX()) ? line(s) : line.LastY();
-
-		return (ta < pred_max_ta);
-	};
-	return false;
-};
-
-//Determine if a mafic rock is non-tholeiitic
-bool EndmemberMNT(const RockSample& R) {
-	if (std::isfinite(R.Silicate) && std::isfinite(R.Potassium) && std::isfinite(R.Sodium)) {
-		return !EndmemberMTT(R);
-	};
-	return false;
-};
-
-Endmembers::Endmembers(size_t N_endmembers) : N_e(N_endmembers), E(N_endmembers), Ename(N_endmembers), ratioErr(N_endmembers) {
+Endmembers::Endmembers(size_t N_endmembers) : EndmemberState(N_endmembers), N_e(N_endmembers), Ename(N_endmembers) {
 };
 
 void Endmembers::RegisterRatioError(MemberOffset<RockSample, double> nominator, MemberOffset<RockSample, double> denominator) {
@@ -254,31 +173,31 @@ void DualEndmembers::GenE() {
 
 	//Run the correct configuration script
 	if (configScript == "MF") {
-		DB_Arch[0].Merge(archaIgn.Select(FuncFilter(EndmemberM))); //Archaean mafic
-		DB_Arch[1].Merge(archaIgn.Select(FuncFilter(EndmemberF))); //Archaean TTG
-		DB_Mdrn[0].Merge(modernNoMORB.Select(FuncFilter(EndmemberM))); //Modern mafic
-		DB_Mdrn[1].Merge(modernIgn.Select(FuncFilter(EndmemberF))); //Modern felsic
+		DB_Arch[0].Merge(archaIgn.Select(LithologyFilter(LITHO_MAFIC))); //Archaean mafic
+		DB_Arch[1].Merge(archaIgn.Select(LithologyFilter(LITHO_FELSIC))); //Archaean TTG
+		DB_Mdrn[0].Merge(modernNoMORB.Select(LithologyFilter(LITHO_MAFIC))); //Modern mafic
+		DB_Mdrn[1].Merge(modernIgn.Select(LithologyFilter(LITHO_FELSIC))); //Modern felsic
 		Ename[0] = "M";
 		Ename[1] = "F";
 	} else if (configScript == "KMF") {
-		DB_Arch[0].Merge(archaIgn.Select(FuncFilter(EndmemberU))); //Komatiite
-		DB_Arch[1].Merge(archaIgn.Select(FuncFilter(EndmemberM))); //Archaean mafic
-		DB_Arch[2].Merge(archaIgn.Select(FuncFilter(EndmemberF))); //Archaean TTG
+		DB_Arch[0].Merge(archaIgn.Select(LithologyFilter(LITHO_KOMATIITE))); //Komatiite
+		DB_Arch[1].Merge(archaIgn.Select(LithologyFilter(LITHO_MAFIC))); //Archaean mafic
+		DB_Arch[2].Merge(archaIgn.Select(LithologyFilter(LITHO_FELSIC))); //Archaean TTG
 		DB_Mdrn[0]; //Empty database (no modern komatiites!)
-		DB_Mdrn[1].Merge(modernNoMORB.Select(FuncFilter(EndmemberM))); //Modern mafic
-		DB_Mdrn[2].Merge(modernIgn.Select(FuncFilter(EndmemberF))); //Modern felsic
+		DB_Mdrn[1].Merge(modernNoMORB.Select(LithologyFilter(LITHO_MAFIC))); //Modern mafic
+		DB_Mdrn[2].Merge(modernIgn.Select(LithologyFilter(LITHO_FELSIC))); //Modern felsic
 		Ename[0] = "K";
 		Ename[1] = "M";
 		Ename[2] = "F";
 	} else if (configScript == "QUARTUS") {
-		DB_Arch[0].Merge(archaIgn.Select(FuncFilter(EndmemberU))); //Komatiite
-		DB_Arch[1].Merge(archaIgn.Select(FuncFilter(EndmemberM))).Refilter(FuncFilter(EndmemberMNT)); //Archaean mafic, non-tholeiitic
-		DB_Arch[2].Merge(archaIgn.Select(FuncFilter(EndmemberM))).Refilter(FuncFilter(EndmemberMTT)); //Archaean mafic, tholeiitic trend
-		DB_Arch[3].Merge(archaIgn.Select(FuncFilter(EndmemberF))); //Archaean TTG
+		DB_Arch[0].Merge(archaIgn.Select(LithologyFilter(LITHO_KOMATIITE))); //Komatiite
+		DB_Arch[1].Merge(archaIgn.Select(LithologyFilter(LITHO_MAFIC | LITHO_NONTHOLEIITIC))); //Archaean mafic, non-tholeiitic
+		DB_Arch[2].Merge(archaIgn.Select(LithologyFilter(LITHO_MAFIC | LITHO_THOLEIITIC))); //Archaean mafic, tholeiitic trend
+		DB_Arch[3].Merge(archaIgn.Select(LithologyFilter(LITHO_FELSIC))); //Archaean TTG
 		DB_Mdrn[0]; //Empty database (no modern komatiites!)
-		DB_Mdrn[1].Merge(modernNoMORB.Select(FuncFilter(EndmemberM))).Refilter(FuncFilter(EndmemberMNT)); //Modern mafic, non-tholeiitic
-		DB_Mdrn[2].Merge(modernNoMORB.Select(FuncFilter(EndmemberM))).Refilter(FuncFilter(EndmemberMTT)); //Modern mafic, tholeiitic trend
-		DB_Mdrn[3].Merge(modernIgn.Select(FuncFilter(EndmemberF))); //Modern felsic
+		DB_Mdrn[1].Merge(modernNoMORB.Select(LithologyFilter(LITHO_MAFIC | LITHO_NONTHOLEIITIC))); //Modern mafic, non-tholeiitic
+		DB_Mdrn[2].Merge(modernNoMORB.Select(LithologyFilter(LITHO_MAFIC | LITHO_THOLEIITIC))); //Modern mafic, tholeiitic trend
+		DB_Mdrn[3].Merge(modernIgn.Select(LithologyFilter(LITHO_FELSIC))); //Modern felsic
 		Ename[0] = "K";
 		Ename[1] = "M-nT";
 		Ename[2] = "M-T";
@@ -389,15 +308,36 @@ DualEndmembers::DualEndmembers(const std::string& CONFIG_SCRIPT,
 //------------------------------------------------------------------\\
 //------------------------------------------------------------------\\
 
+const AgePrefixSums& CumulativeEndmembers::AgeSums(size_t i) {
+	ageSums.resize(N_e);
+	if (ageSums[i].Empty() || ageSums[i].Ratios() != ratioErr_Nmntr.size()) {
+		ageSums[i] = AgePrefixSums(fullDB[i], ratioErr_Nmntr, ratioErr_Dnmtr);
+	};
+	return ageSums[i];
+};
+
+void CumulativeEndmembers::SelectWindow(size_t i) {
+	timeDB[i].Clear().Merge(fullDB[i].Select(RangeFilter(OFF(RockSample::Age), t, t + kernel_length)));
+	//Apply additional weight normalization
+	for (auto& S : timeDB[i].Select(RangeFilter(OFF(RockSample::Age), t + 1000, MAX_AGE))) {
+		S.AppliedWeight *= 0.2;
+	};
+};
+
 void CumulativeEndmembers::RecalcEM() {
 	size_t start_recalc_idx = (configScript != "MF") ? 1 : 0; //Do not recalculate K endmember (if it is present)
 	for (size_t i = start_recalc_idx; i < N_e; ++i) {
-		timeDB[i].Clear().Merge(fullDB[i].Select(RangeFilter(OFF(RockSample::Age), t, t + kernel_length)));
-		//Apply additional weight normalization
-		for (auto& S : timeDB[i].Select(RangeFilter(OFF(RockSample::Age), t + 1000, MAX_AGE))) {
-			S.AppliedWeight *= 0.2;
+		//Same window as SelectWindow, summed straight from the prefix sums
+		const AgePrefixSums& S = AgeSums(i);
+		AgePrefixSums::Window w = S.NewWindow();
+		if (kernel_length < 1000) {
+			S.Add(w, t, t + kernel_length);
+		} else {
+			//Apply additional weight normalization
+			S.Add(w, t, t + 1000, false);
+			S.Add(w, t + 1000, t + kernel_length, true, 0.2);
 		};
-		CalculateWeightedMeanAndRatioErrorsForDB(E[i], timeDB[i], ratioErr[i]);
+		S.Finalise(w, E[i], ratioErr[i]);
 	};
 	if (needToLoadK) {
 		//Calculate K, but only once (since it will not change)
@@ -424,9 +364,9 @@ CumulativeEndmembers::CumulativeEndmembers(const std::string& cScript, const Roc
 	//RockDatabase ign_noOcean(noOceanDB.Select(NanFilter(OFF(RockSample::Age))));
 
 	//auto q_keller_nomorb = ign_keller.Select(RangeFilter(OFF(RockSample::Age), MORB_CUTOFF_AGE, MAX_AGE));
-	auto q_u = ign_keller.Select(FuncFilter(EndmemberU));
-	auto q_m = ign_noOceanW.Select(FuncFilter(EndmemberM));
-	auto q_f = ign_keller.Select(FuncFilter(EndmemberF));
+	auto q_u = ign_keller.Select(LithologyFilter(LITHO_KOMATIITE));
+	auto q_m = ign_noOceanW.Select(LithologyFilter(LITHO_MAFIC));
+	auto q_f = ign_keller.Select(LithologyFilter(LITHO_FELSIC));
 
 	//Run the correct configuration script
 	if (configScript == "MF") {
@@ -445,8 +385,8 @@ CumulativeEndmembers::CumulativeEndmembers(const std::string& cScript, const Roc
 		timeDB[0] = fullDB[0]; //So sample export works correctly
 	} else if (configScript == "QUARTUS") {
 		fullDB[0].Merge(q_u); //Komatiite
-		fullDB[1].Merge(q_m).Refilter(FuncFilter(EndmemberMNT)); //Mafic, non-tholeiitic
-		fullDB[2].Merge(q_m).Refilter(FuncFilter(EndmemberMTT)); //Mafic, tholeiitic trend
+		fullDB[1].Merge(ign_noOceanW.Select(LithologyFilter(LITHO_MAFIC | LITHO_NONTHOLEIITIC))); //Mafic, non-tholeiitic
+		fullDB[2].Merge(ign_noOceanW.Select(LithologyFilter(LITHO_MAFIC | LITHO_THOLEIITIC))); //Mafic, tholeiitic trend
 		fullDB[3].Merge(q_f); //Felsic
 		Ename[0] = "K";
 		Ename[1] = "M-nT";
@@ -460,6 +400,10 @@ CumulativeEndmembers::CumulativeEndmembers(const std::string& cScript, const Roc
 };
 
 std::vector<RockDatabase> CumulativeEndmembers::ExportSamples() {
+	size_t start_recalc_idx = (configScript != "MF") ? 1 : 0;
+	for (size_t i = start_recalc_idx; i < N_e; ++i) {
+		SelectWindow(i);
+	};
 	std::vector<RockDatabase> rtn;
 	for (const auto& db : timeDB) {
 		rtn.push_back(db);
@@ -467,25 +411,49 @@ std::vector<RockDatabase> CumulativeEndmembers::ExportSamples() {
 	return rtn;
 };
 
+const RockDatabase* CumulativeEndmembers::WindowSamples(size_t i) {
+	size_t start_recalc_idx = (configScript != "MF") ? 1 : 0;
+	if (i < start_recalc_idx) {
+		return &fullDB[i]; //K is always averaged over every sample
+	};
+	SelectWindow(i);
+	return &timeDB[i];
+};
+
 //------------------------------------------------------------------\\
 //------------------------------------------------------------------\\
 //---------------------EXPONENTIAL ENDMEMBERS-----------------------\\
 //------------------------------------------------------------------\\
 //------------------------------------------------------------------\\
 
-inline double expKernel(double deltaX, double s) noexcept {
-	return (1.0 / (sqrt(2 * M_PI)*s))*exp(-(deltaX*deltaX) / (2 * s*s));
+void ExponentialEndmembers::SelectWindow(size_t i) {
+	timeDB[i].Clear().Merge(fullDB[i]);
+	for (auto& S : timeDB[i]) {
+		double w = expKernel(S.Age - t, samplingWidth);
+		S.AppliedWeight = w;
+	};
+};
+
+const KernelTimeline& ExponentialEndmembers::Timeline(size_t i) {
+	timelines.resize(N_e);
+	if (timelines[i].Empty() || timelines[i].Ratios() != ratioErr_Nmntr.size()) {
+		timelines[i] = KernelTimeline(fullDB[i], ratioErr_Nmntr, ratioErr_Dnmtr, samplingWidth);
+	};
+	return timelines[i];
 };
 
 void ExponentialEndmembers::RecalcEM() {
 	size_t start_recalc_idx = (configScript != "MF") ? 1 : 0; //Do not recalculate K endmember (if it is present)
 	for (size_t i = start_recalc_idx; i < N_e; ++i) {
-		timeDB[i].Clear().Merge(fullDB[i]);
-		for (auto& S : timeDB[i]) {
-			double w = expKernel(S.Age - t, samplingWidth);
-			S.AppliedWeight = w;
+		const KernelTimeline& T = Timeline(i);
+		KernelTimeline::Window w;
+		if (T.Lookup(t, w)) {
+			T.Finalise(w, E[i], ratioErr[i]);
+		} else {
+			//Outside the grid (or past the reach of the kernel), weight every sample explicitly
+			SelectWindow(i);
+			CalculateWeightedMeanAndRatioErrorsForDB(E[i], timeDB[i], ratioErr[i]);
 		};
-		CalculateWeightedMeanAndRatioErrorsForDB(E[i], timeDB[i], ratioErr[i]);
 	};
 	if (needToLoadK) {
 		//Calculate K, but only once (since it will not change)
@@ -500,13 +468,19 @@ void ExponentialEndmembers::RecalcEM() {
 //------------------------------------------------------------------\\
 //------------------------------------------------------------------\\
 
+void FuturePastEndmembers::SelectWindow(size_t i) {
+	timeDB[i].Clear().Merge(fullDB[i].Select(RangeFilter(OFF(RockSample::Age),
+														 t - samplingWidth,
+														 t + samplingWidth)));
+};
+
 void FuturePastEndmembers::RecalcEM() {
 	size_t start_recalc_idx = (configScript != "MF") ? 1 : 0; //Do not recalculate K endmember (if it is present)
 	for (size_t i = start_recalc_idx; i < N_e; ++i) {
-		timeDB[i].Clear().Merge(fullDB[i].Select(RangeFilter(OFF(RockSample::Age),
-															 t - samplingWidth,
-															 t + samplingWidth)));
-		CalculateWeightedMeanAndRatioErrorsForDB(E[i], timeDB[i], ratioErr[i]);
+		const AgePrefixSums& S = AgeSums(i);
+		AgePrefixSums::Window w = S.NewWindow();
+		S.Add(w, t - samplingWidth, t + samplingWidth);
+		S.Finalise(w, E[i], ratioErr[i]);
 	};
 	if (needToLoadK) {
 		//Calculate K, but only once (since it will not change)
@@ -525,41 +499,38 @@ void BoMembers::GenerateBootstraps(size_t start_idx) {
 	//Load up the elements we will require into a common list
 	bootEl.resize(N_e);
 	bootR.resize(N_e);
+	if (start_idx >= N_e) {
+		return;
+	};
 	//NB: 'Age' is already guaranteed to be non-NaN in the databases, but none of the other elements are!
-	//And since the WXB functions are not NaN-resistant, we have to call std::isfinite() here instead.
-	for (size_t i = start_idx; i < N_e; ++i) {
-		//Bootstrap every element, record in the elemental bootstrap cache
+	//NaNs are masked out of each element (or ratio) separately by the multi-column bootstraps.
+	//Smooth every element: the endmembers run in parallel, and all elements of an endmember share one set of kernel weights.
+	//We don't need errors, only the best fit, so N is set to unity here!
+	const size_t endmemberCount = N_e - start_idx;
+	const size_t innerThreads = std::max<size_t>(1, Parallel::DefaultThreadCount() / endmemberCount);
+	Parallel::For(endmemberCount, 0, [&](size_t, size_t n) {
+		size_t i = start_idx + n;
+		std::vector<std::vector<double>> el;
 		for (const auto& EL : RockSample::allElements) {
-			const auto& O = EL.second;
-			std::vector<double> age;
-			std::vector<double> el;
-			for (const auto& R : fullDB[i]) {
-				double val = O.Data(R);
-				if (std::isfinite(val)) {
-					age.push_back(R.Age);
-					el.push_back(val);
-				};
-			};
-			//We don't need errors, only the best fit, so N is set to unity here!
-			bootEl[i].push_back(WEB_Bootstrap(age, el, bootKernelWidth, 1));
+			el.push_back(fullDB[i].ExtractList(MemberOffset<RockSample, double>(EL.second)));
 		};
-		//Bootstrap all the required ratios
+		bootEl[i] = WEB_MultiBootstrap(fullDB[i].ExtractList(OFF(RockSample::Age)), el, bootKernel, 1, innerThreads, 0);
+	});
+	//Bootstrap all the required ratios of each endmember together
+	if (ratioErr_Nmntr.empty()) {
+		return;
+	};
+	//Only the standard errors are used, so no quantile sketches are kept
+	WRB_Replicates replicates(10000);
+	replicates.quantiles = false;
+	for (size_t i = start_idx; i < N_e; ++i) {
+		std::vector<std::vector<double>> A;
+		std::vector<std::vector<double>> B;
 		for (size_t j = 0; j < ratioErr_Nmntr.size(); ++j) {
-			std::vector<double> age;
-			std::vector<double> A;
-			std::vector<double> B;
-			for (const auto& R : fullDB[i]) {
-				double a = ratioErr_Nmntr[j].Data(R);
-				double b = ratioErr_Dnmtr[j].Data(R);
-				if (std::isfinite(a) && std::isfinite(b)) {
-					age.push_back(R.Age);
-					A.push_back(a);
-					B.push_back(b);
-				};
-			};
-			bootR[i].push_back(WRB_Bootstrap(age, A, B, bootKernelWidth));
-			ratioErr[i].resize(ratioErr.size());
+			A.push_back(fullDB[i].ExtractList(ratioErr_Nmntr[j]));
+			B.push_back(fullDB[i].ExtractList(ratioErr_Dnmtr[j]));
 		};
+		bootR[i] = WRB_MultiBootstrap(fullDB[i].ExtractList(OFF(RockSample::Age)), A, B, bootKernel, replicates, 0, Random::Seed());
 	};
 };
 
@@ -586,3 +557,158 @@ void BoMembers::RecalcEM() {
 		};
 	};
 };
+
+//------------------------------------------------------------------\\
+//------------------------------------------------------------------\\
+//-----------------------ENDMEMBER TIMELINES------------------------\\
+//------------------------------------------------------------------\\
+//------------------------------------------------------------------\\
+
+EndmemberTimeline::EndmemberTimeline(Endmembers& e, double TSTART, double tEnd, double STEP) : tStart(TSTART), step(STEP) {
+	//Same loop as the reconstructions, so that every timestep is computed at exactly the same time
+	for (double t = tStart; t > tEnd; t -= step) {
+		e.RecalculateForTime(t);
+		states.push_back(e);
+	};
+};
+
+const EndmemberState* EndmemberTimeline::At(double t) const {
+	double u = (tStart - t) / step;
+	double k = std::round(u);
+	if (!(std::abs(u - k) < 1e-6) || k < 0.0 || k >= (double)states.size()) {
+		return nullptr;
+	};
+	return &states[(size_t)k];
+};
+
+EndmemberTimeline* EndmemberTimeline::Compositions() const {
+	EndmemberTimeline* rtn = new EndmemberTimeline(tStart, step);
+	rtn->states.reserve(states.size());
+	for (const auto& S : states) {
+		rtn->states.push_back(EndmemberState(S.E.size()));
+		rtn->states.back().E = S.E;
+	};
+	return rtn;
+};
+
+EndmemberTimeline::RatioErrors* EndmemberTimeline::ErrorsOf(size_t r) const {
+	RatioErrors* rtn = new RatioErrors(states.size());
+	for (size_t k = 0; k < states.size(); ++k) {
+		for (const auto& errs : states[k].ratioErr) {
+			(*rtn)[k].push_back(errs[r]);
+		};
+	};
+	return rtn;
+};
+
+EndmemberTimeline* EndmemberTimeline::WithErrors(const std::vector<std::shared_ptr<const RatioErrors>>& ratioErrors) const {
+	EndmemberTimeline* rtn = new EndmemberTimeline(*this);
+	for (size_t k = 0; k < rtn->states.size(); ++k) {
+		auto& S = rtn->states[k];
+		for (size_t j = 0; j < S.ratioErr.size(); ++j) {
+			S.ratioErr[j].clear();
+			for (const auto& errs : ratioErrors) {
+				S.ratioErr[j].push_back((*errs)[k][j]);
+			};
+		};
+	};
+	return rtn;
+};
+
+SharedTables<EndmemberTimeline>& EndmemberTimeline::SharedCompositions() {
+	static SharedTables<EndmemberTimeline> tables;
+	return tables;
+};
+
+SharedTables<EndmemberTimeline::RatioErrors>& EndmemberTimeline::SharedErrors() {
+	static SharedTables<RatioErrors> tables;
+	return tables;
+};
+
+EndmemberBank::EndmemberBank(Endmembers& E, std::shared_ptr<std::mutex> endmemberLock,
+							 const std::vector<MemberOffset<RockSample, double>>& NMNTR, const std::vector<MemberOffset<RockSample, double>>& DMNTR,
+							 double TSTART, double tEnd, double STEP, size_t replicates, uint64 SEED, size_t THREADS)
+	: e(E), lock(endmemberLock), Nmntr(NMNTR), Dmntr(DMNTR), tStart(TSTART), step(STEP), Nrep(replicates),
+	  blockSize(2 * NMNTR.size() * E.N_e), seed(SEED), threads(THREADS) {
+	//Same loop as the reconstructions, so that every timestep is computed at exactly the same time
+	for (double t = tStart; t > tEnd; t -= step) {
+		times.push_back(t);
+	};
+	blocks.resize(times.size());
+};
+
+std::vector<double> EndmemberBank::Draw(size_t ti) const {
+	const size_t Ne = e.N_e;
+	const size_t Nsys = Nmntr.size();
+	std::vector<double> block(Nrep * blockSize);
+
+	//Weights of the samples behind each endmember, and their numerators & denominators (interleaved, per ratio)
+	std::vector<std::vector<double>> weights(Ne);
+	std::vector<std::vector<double>> values(Ne);
+	std::vector<RockSample> means;
+	{
+		std::lock_guard<std::mutex> guard(*lock);
+		e.RecalculateForTime(times[ti]);
+		for (size_t j = 0; j < Ne; ++j) {
+			const RockDatabase* db = e.WindowSamples(j);
+			if (db == nullptr) {
+				throw std::runtime_error("Endmember resampling requires endmembers which are weighted means of samples (Continuous, Exponential or FuturePast)");
+			};
+			for (const RockSample& R : *db) {
+				weights[j].push_back(R.AppliedWeight);
+				for (size_t r = 0; r < Nsys; ++r) {
+					values[j].push_back(Nmntr[r](R));
+					values[j].push_back(Dmntr[r](R));
+				};
+			};
+		};
+		means = e.E;
+	};
+	double* timeBlock = block.data();
+	const size_t streamBase = ti * Nrep;
+	Parallel::For(Nrep, threads, [&](size_t, size_t b) {
+		Random::Stream rng(seed, streamBase + b);
+		double* num = timeBlock + b * blockSize;
+		double* den = num + Nsys * Ne;
+		std::vector<double> sumX(2 * Nsys);
+		std::vector<double> sumW(2 * Nsys);
+		for (size_t j = 0; j < Ne; ++j) {
+			const size_t N = weights[j].size();
+			std::fill(sumX.begin(), sumX.end(), 0.0);
+			std::fill(sumW.begin(), sumW.end(), 0.0);
+			for (size_t n = 0; n < N; ++n) {
+				size_t k = (size_t)rng.Int64(0, (int64)N - 1);
+				double w = weights[j][k];
+				const double* x = &values[j][k * 2 * Nsys];
+				for (size_t q = 0; q < 2 * Nsys; ++q) {
+					if (std::isfinite(x[q])) {
+						sumX[q] += w * x[q];
+						sumW[q] += w;
+					};
+				};
+			};
+			//A replicate which drew no value for an element keeps the endmember's mean
+			for (size_t r = 0; r < Nsys; ++r) {
+				double a = sumX[2 * r] / sumW[2 * r];
+				double c = sumX[2 * r + 1] / sumW[2 * r + 1];
+				num[r * Ne + j] = std::isfinite(a) ? a : Nmntr[r](means[j]);
+				den[r * Ne + j] = std::isfinite(c) ? c : Dmntr[r](means[j]);
+			};
+		};
+	});
+	return block;
+};
+
+const double* EndmemberBank::At(double t) const {
+	double u = (tStart - t) / step;
+	double k = std::round(u);
+	if (!(std::abs(u - k) < 1e-6) || k < 0.0 || k >= (double)blocks.size()) {
+		return nullptr;
+	};
+	std::lock_guard<std::mutex> guard(blocksLock);
+	std::vector<double>& block = blocks[(size_t)k];
+	if (block.empty()) {
+		block = Draw((size_t)k);
+	};
+	return block.data();
+};
@@ -1,9 +1,21 @@
 #pragma once
 #include "reconCommon.h"
+#include <exception>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+
+// Endmember compositions, and the standard errors of the registered ratios (ratioErr[endmember][ratio]), at a single time
+struct EndmemberState {
+	std::vector<RockSample> E;
+	std::vector<std::vector<double>> ratioErr;
+	EndmemberState(size_t N_endmembers = 0) : E(N_endmembers), ratioErr(N_endmembers) {};
+};
 
 // Generic interface used by all continental reconstruction models
 // 
-class Endmembers {
+class Endmembers : public EndmemberState {
 protected:
 	double t;
 	virtual void RecalcEM() = 0;
@@ -13,13 +25,13 @@ protected:
 public:
 	const size_t N_e; //Number of endmembers
 	std::vector<std::string> Ename;
-	std::vector<RockSample> E;
-	std::vector<std::vector<double>> ratioErr;
 	std::vector<MemberOffset<RockSample, double>> ratioErr_Nmntr;
 	std::vector<MemberOffset<RockSample, double>> ratioErr_Dnmtr;
 	void RegisterRatioError(MemberOffset<RockSample, double> nominator, MemberOffset<RockSample, double> denominator);
 	void RecalculateForTime(double t);
 	virtual std::vector<RockDatabase> ExportSamples() = 0;
+	//Samples whose mean (weighted by AppliedWeight) is endmember i at the current time, or null if it is not such a mean
+	virtual const RockDatabase* WindowSamples(size_t) { return nullptr; };
 	virtual ~Endmembers();
 	static RockDatabase CreateAgeUniformDatabase(const RockDatabase& inDB, double width);
 };
@@ -64,10 +76,17 @@ protected:
 	double kernel_length;
 	bool needToLoadK;
 
+	//Per-endmember age prefix sums, built on first use (once the ratio errors are registered)
+	std::vector<AgePrefixSums> ageSums;
+	const AgePrefixSums& AgeSums(size_t i);
+	//Copies the samples (and weights) of endmember i at the current time into timeDB[i], for export
+	virtual void SelectWindow(size_t i);
+
 public:
 	void RecalcEM() override;
 	CumulativeEndmembers(const std::string& configScript, const RockDatabase& kellerDB, const RockDatabase& noOceanDB, double kernel_length, double sampling_width);
 	std::vector<RockDatabase> ExportSamples() override;
+	const RockDatabase* WindowSamples(size_t i) override;
 };
 
 // Special-case version of the above, with an infinite kernel length.
@@ -82,6 +101,11 @@ public:
 // smoothing kernel instead of a Heaviside kernel.
 class ExponentialEndmembers : public ContinuousEndmembers {
 	double samplingWidth;
+	//Per-endmember sums over a grid of times, built on first use (once the ratio errors are registered)
+	std::vector<KernelTimeline> timelines;
+	const KernelTimeline& Timeline(size_t i);
+protected:
+	void SelectWindow(size_t i) override;
 public:
 	void RecalcEM() override;
 	ExponentialEndmembers(const std::string& configScript, const RockDatabase& kellerDB, const RockDatabase& noOceanDB, double agebinWidth, double kernelWidth)
@@ -92,6 +116,8 @@ public:
 // unit function kernel instead of a Heaviside kernel.
 class FuturePastEndmembers : public ContinuousEndmembers {
 	double samplingWidth;
+protected:
+	void SelectWindow(size_t i) override;
 public:
 	void RecalcEM() override;
 	FuturePastEndmembers(const std::string& configScript, const RockDatabase& kellerDB, const RockDatabase& noOceanDB, double agebinWidth, double kernelWidth)
@@ -104,9 +130,112 @@ class BoMembers : public ContinuousEndmembers {
 	std::vector<std::vector<WRB_Result>> bootEl;
 	std::vector<std::vector<WRB_Result>> bootR;
 	void GenerateBootstraps(size_t start_idx);
-	double bootKernelWidth;
+	WRB_Kernel bootKernel;
+protected:
+	void SelectWindow(size_t) override {}; //Bootstrapped endmembers are not averages over a window of samples
 public:
 	void RecalcEM() override;
-	BoMembers(const std::string& configScript, const RockDatabase & IGN_KELLER, const RockDatabase & IGN_NOMORB, double BOOT_KERNEL_WIDTH = 500.0)
-		: ContinuousEndmembers(configScript, IGN_KELLER, IGN_NOMORB, 999999.9), bootKernelWidth(BOOT_KERNEL_WIDTH) {};
+	const RockDatabase* WindowSamples(size_t) override { return nullptr; };
+	//A bin width in the kernel makes the (large) igneous bootstraps use the binned approximation (see WRB_Kernel)
+	BoMembers(const std::string& configScript, const RockDatabase & IGN_KELLER, const RockDatabase & IGN_NOMORB, const WRB_Kernel& BOOT_KERNEL = 500.0)
+		: ContinuousEndmembers(configScript, IGN_KELLER, IGN_NOMORB, 999999.9), bootKernel(BOOT_KERNEL) {};
+};
+
+// Process-wide cache of read-only tables, kept until the process exits
+// A missing entry is claimed by a single caller, which builds it without holding the cache lock (so that unrelated keys
+// are built concurrently) and then publishes it; other callers of that key wait for it.
+template<typename T>
+class SharedTables {
+public:
+	typedef std::shared_ptr<const T> Ptr;
+	typedef std::shared_ptr<std::promise<Ptr>> Claim;
+
+	//Returns the (possibly still pending) entry stored under 'key'
+	//On a miss, returns an invalid future instead, and sets 'claim', which the caller must Publish or Abandon
+	std::shared_future<Ptr> Find(uint64 key, Claim& claim) {
+		std::lock_guard<std::mutex> guard(lock);
+		auto it = entries.find(key);
+		if (it != entries.end()) {
+			return it->second;
+		};
+		claim = std::make_shared<std::promise<Ptr>>();
+		entries[key] = claim->get_future().share();
+		return std::shared_future<Ptr>();
+	};
+	void Publish(const Claim& claim, Ptr value) {
+		claim->set_value(value);
+	};
+	//Forgets a claimed entry whose build failed (so that a later call retries), and passes the error on to its waiters
+	void Abandon(uint64 key, const Claim& claim, std::exception_ptr error) {
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			entries.erase(key);
+		};
+		claim->set_exception(error);
+	};
+private:
+	std::mutex lock;
+	std::map<uint64, std::shared_future<Ptr>> entries;
+};
+
+// Endmember states at every time of a reconstruction grid (tStart, tStart - step, ... while above tEnd), computed once
+// and then only read, so that one table can be shared between threads and ReconManagers.
+// The compositions do not depend on the registered ratios, and the errors of each ratio do not depend on the other ratios,
+// so the process-wide caches hold them apart (see ReconManager::GetEndmemberTimeline), and each table is assembled from them.
+class EndmemberTimeline {
+	double tStart;
+	double step;
+	std::vector<EndmemberState> states;
+	EndmemberTimeline(double TSTART, double STEP) : tStart(TSTART), step(STEP) {};
+public:
+	//Standard errors of a single ratio, [time][endmember]
+	typedef std::vector<std::vector<double>> RatioErrors;
+
+	EndmemberTimeline(Endmembers& e, double tStart, double tEnd, double step);
+	//State at time t, or null if t is not on the grid
+	const EndmemberState* At(double t) const;
+
+	//Copy of the table without any ratio errors
+	EndmemberTimeline* Compositions() const;
+	//Errors of ratio r at every time of the grid
+	RatioErrors* ErrorsOf(size_t r) const;
+	//Copy of the compositions, with the given errors of every ratio
+	EndmemberTimeline* WithErrors(const std::vector<std::shared_ptr<const RatioErrors>>& ratioErrors) const;
+
+	//Process-wide caches of the compositions, and of the errors of single ratios
+	static SharedTables<EndmemberTimeline>& SharedCompositions();
+	static SharedTables<RatioErrors>& SharedErrors();
+};
+
+// Bootstrap replicates of the ratio numerators & denominators of every endmember, at every time of a reconstruction grid
+// Each replicate resamples the samples behind every endmember (see Endmembers::WindowSamples) with replacement.
+// Layout: [time][replicate][numerator, denominator][ratio][endmember], i.e. every (time, replicate) block holds the
+// endmember arrays of the MCMC, so that a replicate is selected by its offset alone.
+// The replicates of a time are only drawn when it is first looked up (recalculating the endmembers under 'lock'), so that
+// a fine grid, of which only a few times are run (e.g. an adaptive timeline), stays cheap. Every time draws from its own
+// random streams, so the replicates do not depend on the order in which times are looked up.
+class EndmemberBank {
+	Endmembers& e;
+	std::shared_ptr<std::mutex> lock;
+	std::vector<MemberOffset<RockSample, double>> Nmntr;
+	std::vector<MemberOffset<RockSample, double>> Dmntr;
+	double tStart;
+	double step;
+	std::vector<double> times;
+	size_t Nrep;
+	size_t blockSize;
+	uint64 seed;
+	size_t threads;
+	mutable std::mutex blocksLock;
+	mutable std::vector<std::vector<double>> blocks; //[time], empty until drawn
+	std::vector<double> Draw(size_t ti) const;
+public:
+	EndmemberBank(Endmembers& e, std::shared_ptr<std::mutex> endmemberLock,
+				  const std::vector<MemberOffset<RockSample, double>>& Nmntr, const std::vector<MemberOffset<RockSample, double>>& Dmntr,
+				  double tStart, double tEnd, double step, size_t replicates, uint64 seed, size_t threads = 0);
+	size_t Replicates() const { return Nrep; };
+	//Size of the block of a single replicate
+	size_t BlockSize() const { return blockSize; };
+	//Block of the first replicate at time t (drawn on first use), or null if t is not on the grid
+	const double* At(double t) const;
 };
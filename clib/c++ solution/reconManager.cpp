@@ -5,24 +5,167 @@ MemberOffset<RockSample, double> ReconManager::TranslateOffset(const std::string
 	return MemberOffset<RockSample, double>((MemberOffsetBase)RockSample::allElements[sysName]);
 };
 
-WRB_Result ReconManager::GenerateBootstrapIMPL(const MemberOffset<RockSample, double>& A, const MemberOffset<RockSample, double>& B) {
+WRB_ErrorMode ReconManager::BootstrapErrorMode() const {
+	std::string mode = initConfig.Contains("BootstrapErrors") ? initConfig.Get("BootstrapErrors") : "Resample";
+	if (mode == "Analytic") {
+		return WRB_ErrorMode::Analytic;
+	} else if (mode != "Resample") {
+		throw std::runtime_error("Unrecognised bootstrap error mode '" + mode + "'");
+	};
+	return WRB_ErrorMode::Resample;
+};
+
+WRB_Replicates ReconManager::BootstrapReplicates() const {
+	WRB_Replicates r(10000);
+	if (initConfig.Contains("BootstrapPrecision")) {
+		r = WRB_Replicates::Adaptive(initConfig.GetOr<double>("BootstrapPrecision", 0.0),
+									 initConfig.GetOr<size_t>("BootstrapMinIter", 500),
+									 initConfig.GetOr<size_t>("BootstrapMaxIter", 20000));
+	};
+	r.quantiles = (initConfig.GetOr<size_t>("BootstrapQuantiles", 0) != 0);
+	return r;
+};
+
+void ReconManager::ExtractBootstrapData(const MemberOffset<RockSample, double>& A, const MemberOffset<RockSample, double>& B, std::vector<double>& age, std::vector<double>& a, std::vector<double>& b) {
 	//Strip NaNs
 	auto ageList = shales.ExtractList(OFF(RockSample::Age));
 	auto AList = shales.ExtractList(A);
 	auto BList = shales.ExtractList(B);
-	std::vector<double> ageListFiltered, AListFiltered, BListFiltered;
 	for (size_t j = 0; j < ageList.size(); ++j) {
 		if (std::isfinite(ageList[j]) && std::isfinite(AList[j]) && std::isfinite(BList[j])) {
-			ageListFiltered.push_back(ageList[j]);
-			AListFiltered.push_back(AList[j]);
-			BListFiltered.push_back(BList[j]);
+			age.push_back(ageList[j]);
+			a.push_back(AList[j]);
+			b.push_back(BList[j]);
 		};
 	};
+};
+
+WRB_Kernel ReconManager::BootstrapKernel() const {
+	return WRB_Kernel(kernelWidth, initConfig.GetOr<double>("BootstrapBinWidth", 0.0));
+};
+
+uint64 ReconManager::BootstrapSeed() const {
+	return initConfig.Contains("BootstrapSeed") ? (uint64)initConfig.GetOr<size_t>("BootstrapSeed", 0) : Random::Seed();
+};
+
+uint64 ReconManager::BootstrapKey(const std::vector<double>& age, const std::vector<double>& a, const std::vector<double>& b, const WRB_Kernel& kernel, const WRB_Replicates& replicates, uint64 seed) const {
+	ContentHash key;
+	key.Add(std::string((BootstrapErrorMode() == WRB_ErrorMode::Analytic) ? "WRBA" : "WRB"));
+	key.Add(age);
+	key.Add(a);
+	key.Add(b);
+	key.Add(kernel.width);
+	//Exact bootstraps keep the keys they had before binning existed
+	if (kernel.binWidth > 0.0) {
+		key.Add(kernel.binWidth);
+	};
+	key.Add((uint64)replicates.minIter);
+	key.Add((uint64)replicates.maxIter);
+	key.Add(replicates.precision);
+	key.Add((uint64)replicates.quantiles);
+	key.Add(seed);
+	return key.Value();
+};
+
+WRB_Result ReconManager::GenerateBootstrapIMPL(const MemberOffset<RockSample, double>& A, const MemberOffset<RockSample, double>& B) {
+	std::vector<double> ageListFiltered, AListFiltered, BListFiltered;
+	ExtractBootstrapData(A, B, ageListFiltered, AListFiltered, BListFiltered);
+	//The seed is drawn whether or not the cache hits, so that later random numbers do not depend on the cache
+	const WRB_Replicates replicates = BootstrapReplicates();
+	uint64 seed = BootstrapSeed();
+	const WRB_Kernel kernel = BootstrapKernel();
+	uint64 key = BootstrapKey(ageListFiltered, AListFiltered, BListFiltered, kernel, replicates, seed);
+	WRB_Result r;
+	if (bootCache.Load(key, r)) {
+		return r;
+	};
 	//Bootstrap
-	return WRB_Bootstrap(ageListFiltered, AListFiltered, BListFiltered, kernelWidth);
+	if (BootstrapErrorMode() == WRB_ErrorMode::Analytic) {
+		r = WRB_AnalyticBootstrap(ageListFiltered, AListFiltered, BListFiltered, kernel);
+	} else {
+		r = WRB_Bootstrap(ageListFiltered, AListFiltered, BListFiltered, kernel, replicates, initConfig.GetOr<size_t>("BootstrapThreads", 0), seed);
+	};
+	bootCache.Store(key, r);
+	return r;
+};
+
+std::vector<WRB_Result> ReconManager::GenerateBootstrapSweep(const std::string& A, const std::string& B, const std::vector<double>& kernelWidths) {
+	std::vector<double> age, a, b;
+	ExtractBootstrapData(TranslateOffset(A), TranslateOffset(B), age, a, b);
+	const WRB_Replicates replicates = BootstrapReplicates();
+	const WRB_Kernel kernel = BootstrapKernel();
+	uint64 seed = BootstrapSeed();
+	//Every width gives the same result as GenerateBootstrap (so they share cache entries)
+	std::vector<WRB_Result> results(kernelWidths.size());
+	std::vector<uint64> keys(kernelWidths.size());
+	std::vector<size_t> missing;
+	std::vector<double> missingWidths;
+	for (size_t w = 0; w < kernelWidths.size(); ++w) {
+		keys[w] = BootstrapKey(age, a, b, WRB_Kernel(kernelWidths[w], kernel.binWidth), replicates, seed);
+		if (!bootCache.Load(keys[w], results[w])) {
+			missing.push_back(w);
+			missingWidths.push_back(kernelWidths[w]);
+		};
+	};
+	if (!missing.empty()) {
+		auto boot = WRB_BandwidthSweep(age, a, b, missingWidths, replicates, initConfig.GetOr<size_t>("BootstrapThreads", 0), seed, BootstrapErrorMode(), kernel.binWidth);
+		for (size_t m = 0; m < missing.size(); ++m) {
+			results[missing[m]] = boot[m];
+			bootCache.Store(keys[missing[m]], boot[m]);
+		};
+	};
+	return results;
+};
+
+std::vector<WRB_Result> ReconManager::GenerateBootstrapsIMPL(const std::vector<MemberOffset<RockSample, double>>& A, const std::vector<MemberOffset<RockSample, double>>& B) {
+	const WRB_Replicates replicates = BootstrapReplicates();
+	const WRB_ErrorMode mode = BootstrapErrorMode();
+	const WRB_Kernel kernel = BootstrapKernel();
+	uint64 seed = BootstrapSeed();
+	auto ageList = shales.ExtractList(OFF(RockSample::Age));
+	std::vector<WRB_Result> results(A.size());
+	std::vector<uint64> keys(A.size());
+	std::vector<size_t> missing;
+	std::vector<std::vector<double>> AList, BList;
+	for (size_t i = 0; i < A.size(); ++i) {
+		auto a = shales.ExtractList(A[i]);
+		auto b = shales.ExtractList(B[i]);
+		ContentHash key;
+		key.Add(std::string((mode == WRB_ErrorMode::Analytic) ? "WRBMA" : "WRBM"));
+		key.Add(ageList);
+		key.Add(a);
+		key.Add(b);
+		key.Add(kernel.width);
+		if (kernel.binWidth > 0.0) {
+			key.Add(kernel.binWidth);
+		};
+		key.Add((uint64)replicates.minIter);
+		key.Add((uint64)replicates.maxIter);
+		key.Add(replicates.precision);
+		key.Add((uint64)replicates.quantiles);
+		key.Add(seed);
+		keys[i] = key.Value();
+		if (!bootCache.Load(keys[i], results[i])) {
+			missing.push_back(i);
+			AList.push_back(a);
+			BList.push_back(b);
+		};
+	};
+	//Each ratio's result does not depend on the other ratios bootstrapped with it (with an adaptive replicate count too, as every
+	//ratio stops on its own, see WRB_Replicates), so the misses can be run on their own and every ratio is cached on its own
+	if (!missing.empty()) {
+		auto boot = WRB_MultiBootstrap(ageList, AList, BList, kernel, replicates, initConfig.GetOr<size_t>("BootstrapThreads", 0), seed, mode);
+		for (size_t m = 0; m < missing.size(); ++m) {
+			results[missing[m]] = boot[m];
+			bootCache.Store(keys[missing[m]], boot[m]);
+		};
+	};
+	return results;
 };
 
 void ReconManager::AddRatio(const std::string & RNAME, MemberOffset<RockSample, double> NOM, MemberOffset<RockSample, double> DNM) {
+	//The background refinement reads the ratios & bootstraps on every timestep
+	StopProgressiveReconstruction();
 	nameR.push_back(RNAME);
 	Nmntr.push_back(NOM);
 	Dmntr.push_back(DNM);
@@ -33,6 +176,7 @@ size_t ReconManager::CountRatios() const {
 };
 
 void ReconManager::AddBootstrap(const WRB_Result & r) {
+	StopProgressiveReconstruction();
 	bestF.push_back(r.bestFit);
 	errMF.push_back(r.stdError);
 };
@@ -63,18 +207,110 @@ WRB_Result ReconManager::GenerateBootstrap(const std::string & A, const std::str
 	return GenerateBootstrapIMPL(TranslateOffset(A), TranslateOffset(B));
 };
 
+std::vector<WRB_Result> ReconManager::GenerateBootstraps(const std::vector<std::string>& A, const std::vector<std::string>& B) {
+	if (A.size() != B.size()) {
+		throw std::runtime_error("GenerateBootstraps: expected as many numerators as denominators");
+	};
+	std::vector<MemberOffset<RockSample, double>> a, b;
+	for (size_t i = 0; i < A.size(); ++i) {
+		a.push_back(TranslateOffset(A[i]));
+		b.push_back(TranslateOffset(B[i]));
+	};
+	return GenerateBootstrapsIMPL(a, b);
+};
+
+ResultsTable ReconManager::CrossValidateKernelWidth(const std::string& A, const std::string& B, const std::vector<double>& kernelWidths) {
+	std::vector<double> age, a, b;
+	ExtractBootstrapData(TranslateOffset(A), TranslateOffset(B), age, a, b);
+	auto score = WRB_CrossValidation(age, a, b, kernelWidths, initConfig.GetOr<size_t>("BootstrapThreads", 0));
+	ResultsTable T;
+	T.AddColumn("KernelWidth");
+	T.AddColumn("CVScore");
+	T[0] = kernelWidths;
+	T[1] = score;
+	return T;
+};
+
+double ReconManager::SelectKernelWidth(const std::string& A, const std::string& B, const std::vector<double>& kernelWidths) {
+	auto T = CrossValidateKernelWidth(A, B, kernelWidths);
+	double best = NAN;
+	double bestScore = INFINITY;
+	for (size_t w = 0; w < T.Rows(); ++w) {
+		if (T[1][w] < bestScore) {
+			bestScore = T[1][w];
+			best = T[0][w];
+		};
+	};
+	return best;
+};
+
+ResultsTable ReconManager::CompareBootstrapErrors(const std::string& A, const std::string& B) {
+	std::vector<double> age, a, b;
+	ExtractBootstrapData(TranslateOffset(A), TranslateOffset(B), age, a, b);
+	WRB_Result resampled = WRB_Bootstrap(age, a, b, kernelWidth, 10000, initConfig.GetOr<size_t>("BootstrapThreads", 0));
+	WRB_Result analytic = WRB_AnalyticBootstrap(age, a, b, kernelWidth);
+	ResultsTable T;
+	T.AddColumn("Age");
+	T.AddColumn("BestFit");
+	T.AddColumn("ResampleSE");
+	T.AddColumn("AnalyticSE");
+	T.AddColumn("Ratio");
+	const auto& X = analytic.stdError.xs;
+	T[0] = X;
+	T[1] = analytic.bestFit.Evaluate(X);
+	T[2] = resampled.stdError.Evaluate(X);
+	T[3] = analytic.stdError.ys;
+	for (size_t j = 0; j < X.size(); ++j) {
+		T[4].push_back(T[3][j] / T[2][j]);
+	};
+	return T;
+};
+
+ResultsTable ReconManager::CompareBinnedBootstrap(const std::string& A, const std::string& B, double binWidth) {
+	std::vector<double> age, a, b;
+	ExtractBootstrapData(TranslateOffset(A), TranslateOffset(B), age, a, b);
+	//The same seed for both, so that they only differ by the binning
+	const WRB_Kernel binned(kernelWidth, binWidth);
+	const size_t threads = initConfig.GetOr<size_t>("BootstrapThreads", 0);
+	uint64 seed = Random::Seed();
+	WRB_Result exact = WRB_Bootstrap(age, a, b, kernelWidth, 1000, threads, seed);
+	WRB_Result approx = WRB_Bootstrap(age, a, b, binned, 1000, threads, seed);
+	ResultsTable T;
+	T.AddColumn("Age");
+	T.AddColumn("BestFit");
+	T.AddColumn("BinnedFit");
+	T.AddColumn("StdError");
+	T.AddColumn("BinnedStdError");
+	T.AddColumn("FitError");
+	const auto& X = exact.stdError.xs;
+	T[0] = X;
+	T[1] = exact.bestFit.Evaluate(X);
+	T[2] = approx.bestFit.Evaluate(X);
+	T[3] = exact.stdError.ys;
+	T[4] = approx.stdError.Evaluate(X);
+	for (size_t j = 0; j < X.size(); ++j) {
+		T[5].push_back(std::abs(T[2][j] - T[1][j]) / T[3][j]);
+	};
+	std::cout << "BINNED BOOTSTRAP: KERNEL WEIGHT ERROR BOUND " << binned.BinningErrorBound() << " OF PEAK" << std::endl;
+	return T;
+};
+
 void ReconManager::GenerateAllBootstraps() {
-	for (size_t i = 0; i < CountRatios(); ++i) {
-		AddBootstrap(GenerateBootstrapIMPL(Nmntr[i], Dmntr[i]));
+	StopProgressiveReconstruction();
+	for (const auto& r : GenerateBootstrapsIMPL(Nmntr, Dmntr)) {
+		AddBootstrap(r);
 	};
 };
 
 void ReconManager::ResetAllBootstraps() {
+	StopProgressiveReconstruction();
 	bestF.clear();
 	errMF.clear();
 };
 
-ReconManager::ReconManager(DenseStringMap conf, const std::string & DB) : kernelWidth(StringToData<double>(conf["BootstrapKernelWidth"][0])), initConfig(conf) {
+ReconManager::ReconManager(DenseStringMap conf, const std::string & DB) : kernelWidth(StringToData<double>(conf["BootstrapKernelWidth"][0])), initConfig(conf),
+	sinks(std::make_shared<ResultsSinkList>()), bootCache(conf.Contains("BootstrapCache") ? conf.Get("BootstrapCache") : ""),
+	endmemberLock(std::make_shared<std::mutex>()) {
 	//Load shale database (either from standard folder, or from supplied string)
 	StandardGeochemDatabase db_shales;
 	db_shales.SetName("Filtered global shales");
@@ -119,50 +355,30 @@ ReconManager::ReconManager(DenseStringMap conf, const std::string & DB) : kernel
 		E = new FuturePastEndmembers(endScript, *parsedDB_Keller, *parsedDB_nomorb, ABwidth, Kwidth);
 	} else if (endMode == "Bootstrap") {
 		double Kwidth = StringToData<double>(conf["KernelWidth"][0]);
-		auto* EPTR = new BoMembers(endScript, *parsedDB_Keller, *parsedDB_nomorb, Kwidth);
+		auto* EPTR = new BoMembers(endScript, *parsedDB_Keller, *parsedDB_nomorb, WRB_Kernel(Kwidth, conf.GetOr<double>("BootstrapBinWidth", 0.0)));
 		E = EPTR;
 	} else {
 		throw new std::runtime_error("Unrecognised endmember mode '" + endMode + "'");
 	};
 
 	//Select reconstruction program to execute
+	//(the results processors to run are chosen by the reconstruction itself, see ResultsProcessorSet)
 	execRecon = nullptr;
 	std::string reconMode = conf["reconMode"][0];
-	if (!conf.Contains("detailedRatioPrinter")) {
-		//Standard reporting mode (endmember confidence intervals)
-		if (reconMode == "MCMC") {
-			switch(E->N_e) {
-			case 2:
-				execRecon = &MCMCRecon::RunMarkovModel_2M;
-				break;
-			case 3:
-				execRecon = &MCMCRecon::RunMarkovModel_3M;
-				break;
-			case 4:
-				execRecon = &MCMCRecon::RunMarkovModel_4M;
-				break;
-			case 5:
-				execRecon = &MCMCRecon::RunMarkovModel_5M;
-				break;
-			};
-		};
-	} else {
-		//Ratio reporting mode (ratio confidence intervals)
-		if (reconMode == "MCMC") {
-			switch (E->N_e) {
-			case 2:
-				execRecon = &MCMCRecon::RunMarkovModel_2M_Ratios;
-				break;
-			case 3:
-				execRecon = &MCMCRecon::RunMarkovModel_3M_Ratios;
-				break;
-			case 4:
-				execRecon = &MCMCRecon::RunMarkovModel_4M_Ratios;
-				break;
-			case 5:
-				execRecon = &MCMCRecon::RunMarkovModel_5M_Ratios;
-				break;
-			};
+	if (reconMode == "MCMC") {
+		switch(E->N_e) {
+		case 2:
+			execRecon = &MCMCRecon::RunMarkovModel_2M;
+			break;
+		case 3:
+			execRecon = &MCMCRecon::RunMarkovModel_3M;
+			break;
+		case 4:
+			execRecon = &MCMCRecon::RunMarkovModel_4M;
+			break;
+		case 5:
+			execRecon = &MCMCRecon::RunMarkovModel_5M;
+			break;
 		};
 	};
 
@@ -176,33 +392,119 @@ double ReconManager::GetNearestValidTime(double start_time, bool scan_forward) c
 	const double step_size = 1.0;
 	double step = (scan_forward) ? +step_size : -step_size;
 
-	for (double t = start_time;; t += step_size) {
-		for (size_t i = 0; i < CountRatios(); ++i) {
-			if (!(std::isfinite(bestF[i](t)) &&
-				  std::isfinite(errMF[i](t)))) {
-				continue;
-			};
+	//Past the span of every bootstrap there is nothing left to find
+	double first = INFINITY;
+	double last = -INFINITY;
+	for (size_t i = 0; i < bestF.size(); ++i) {
+		first = std::min(first, std::min(bestF[i].FirstX(), errMF[i].FirstX()));
+		last = std::max(last, std::max(bestF[i].LastX(), errMF[i].LastX()));
+	};
+	for (double t = start_time; bestF.empty() || (scan_forward ? (t <= last) : (t >= first)); t += step) {
+		bool valid = true;
+		for (size_t i = 0; valid && (i < bestF.size()); ++i) {
+			valid = std::isfinite(bestF[i](t)) && std::isfinite(errMF[i](t));
+		};
+		if (valid) {
+			return t;
 		};
-		return t;
 	};
 	return NAN;
 };
 
 std::string ReconManager::RunReconstruction() const {
+	//The background refinement shares the endmembers (and the endmember lock) with us
+	if (progressive) {
+		progressive->Stop();
+	};
+	return execRecon(*this).front().second.ToCSV();
+};
+
+ReconOutputs ReconManager::RunReconstructionAll() const {
+	if (progressive) {
+		progressive->Stop();
+	};
 	return execRecon(*this);
 };
 
+std::vector<std::string> ReconManager::RunReconstructionToFiles(const std::string& pathPrefix) const {
+	std::vector<std::string> files;
+	for (const auto& out : RunReconstructionAll()) {
+		files.push_back(pathPrefix + "_" + out.first + ".hlt");
+		out.second.WriteBinary(files.back());
+	};
+	return files;
+};
+
+std::string ReconManager::StartProgressiveReconstruction() {
+	StopProgressiveReconstruction();
+	if (initConfig.Get("reconMode") != "MCMC") {
+		throw std::runtime_error("Progressive reconstructions are only available in MCMC mode");
+	};
+	progressive.reset(MCMCRecon::CreateProgressiveMarkovModel(*this));
+	progressive->Start();
+	return progressive->Snapshot();
+};
+
+std::string ReconManager::GetReconstructionSnapshot() const {
+	return progressive ? progressive->Snapshot() : "";
+};
+
+size_t ReconManager::GetSnapshotVersion() const {
+	return progressive ? progressive->Version() : 0;
+};
+
+bool ReconManager::IsRefining() const {
+	return progressive ? progressive->Running() : false;
+};
+
+void ReconManager::StopProgressiveReconstruction() {
+	if (progressive) {
+		progressive->Stop();
+	};
+};
+
+std::shared_ptr<ResultsSink> ReconManager::GetResultsSink() const {
+	if (sinks->Empty()) {
+		return nullptr;
+	};
+	return sinks;
+};
+
+void ReconManager::AddResultsSink(std::shared_ptr<ResultsSink> sink) {
+	sinks->Add(sink);
+};
+
+void ReconManager::ClearResultsSinks() {
+	sinks->Clear();
+	memorySink.reset();
+};
+
+void ReconManager::StreamToFile(const std::string& pathPrefix) {
+	AddResultsSink(std::make_shared<FileResultsSink>(pathPrefix));
+};
+
+void ReconManager::StreamToMemory() {
+	if (!memorySink) {
+		memorySink = std::make_shared<MemoryResultsSink>();
+		AddResultsSink(memorySink);
+	};
+};
+
+ReconOutputs ReconManager::DrainStream() {
+	return memorySink ? memorySink->Drain() : ReconOutputs();
+};
+
 std::vector<double> ReconManager::ForwardModelCalc(double t, const std::vector<double>& p) const {
 	std::vector<double> rVal(CountRatios());
 
-	E->RecalculateForTime(t);
+	EndmemberState e = RecalculateEndmembers(t);
 
 	for (size_t i = 0; i < CountRatios(); ++i) {
 		double sumA = 0.0;
 		double sumB = 0.0;
 		for (size_t j = 0; j < GetEndmemberCount(); ++j) {
-			sumA += p[j] * Nmntr[i](E->E[j]);
-			sumB += p[j] * Dmntr[i](E->E[j]);
+			sumA += p[j] * Nmntr[i](e.E[j]);
+			sumB += p[j] * Dmntr[i](e.E[j]);
 		};
 		rVal[i] = sumA / sumB;
 	};
@@ -211,13 +513,13 @@ std::vector<double> ReconManager::ForwardModelCalc(double t, const std::vector<d
 };
 
 double ReconManager::ForwardModelCalc(double t, const std::vector<double>& p, MemberOffset<RockSample, double> el) const {
-	E->RecalculateForTime(t);
+	EndmemberState e = RecalculateEndmembers(t);
 
 	double sumA = 0.0;
 	double sumB = 0.0;
 	for (size_t j = 0; j < GetEndmemberCount(); ++j) {
-		sumA += p[j] * el(E->E[j]);
-		sumB += p[j] * el(E->E[j]);
+		sumA += p[j] * el(e.E[j]);
+		sumB += p[j] * el(e.E[j]);
 	};
 	return sumA / sumB;
 };
@@ -230,6 +532,114 @@ size_t ReconManager::GetEndmemberCount() const {
 	return E->E.size();
 };
 
+namespace {
+	//Hash of everything in a database that the endmembers may depend on
+	void AddDatabase(ContentHash& key, const RockDatabase& db) {
+		key.Add((uint64)db.size());
+		for (const RockSample& R : db) {
+			for (const auto& V : RockSample::allNumericValues) {
+				key.Add(V.second.Data(&R));
+			};
+			key.Add(R.Age);
+			key.Add(R.AppliedWeight);
+			key.Add((R.RockName != nullptr) ? *R.RockName : std::string());
+			key.Add((R.RockType != nullptr) ? *R.RockType : std::string());
+		};
+	};
+};
+
+std::shared_ptr<const EndmemberTimeline> ReconManager::GetEndmemberTimeline(double tStart, double tEnd, double step) const {
+	auto build = [&]() {
+		std::lock_guard<std::mutex> guard(*endmemberLock);
+		std::cout << "ENDMEMBER TIMELINE: COMPUTING " << E->N_e << " ENDMEMBERS FROM " << tStart << "Ma, EVERY " << step << "Myr" << std::endl;
+		return new EndmemberTimeline(*E, tStart, tEnd, step);
+	};
+	if (initConfig.GetOr<std::string>("endmemberMode", "") == "Bootstrap") {
+		return std::shared_ptr<const EndmemberTimeline>(build());
+	};
+	//The compositions are keyed by the endmember configuration & databases only, the errors additionally by their ratio
+	ContentHash key;
+	key.Add(std::string("EMTL"));
+	for (const char* K : { "endmemberMode", "endmemberScript", "AgeBinWidth", "KernelWidth" }) {
+		key.Add(initConfig.GetOr<std::string>(K, ""));
+	};
+	AddDatabase(key, *parsedDB_Keller);
+	AddDatabase(key, *parsedDB_nomorb);
+	key.Add(tStart);
+	key.Add(tEnd);
+	key.Add(step);
+	std::vector<uint64> errorKeys;
+	for (const auto& name : nameR) {
+		ContentHash errorKey = key;
+		errorKey.Add(name);
+		errorKeys.push_back(errorKey.Value());
+	};
+
+	//Whoever claims a missing entry builds the whole table (every entry follows from it), and uses it as it is
+	auto& compositions = EndmemberTimeline::SharedCompositions();
+	auto& errors = EndmemberTimeline::SharedErrors();
+	SharedTables<EndmemberTimeline>::Claim compositionsClaim;
+	auto compositionsEntry = compositions.Find(key.Value(), compositionsClaim);
+	std::vector<SharedTables<EndmemberTimeline::RatioErrors>::Claim> errorClaims(nameR.size());
+	std::vector<std::shared_future<std::shared_ptr<const EndmemberTimeline::RatioErrors>>> errorEntries;
+	bool claimed = (compositionsClaim != nullptr);
+	for (size_t r = 0; r < nameR.size(); ++r) {
+		errorEntries.push_back(errors.Find(errorKeys[r], errorClaims[r]));
+		claimed = claimed || (errorClaims[r] != nullptr);
+	};
+	if (claimed) {
+		try {
+			std::shared_ptr<const EndmemberTimeline> table(build());
+			if (compositionsClaim) {
+				compositions.Publish(compositionsClaim, std::shared_ptr<const EndmemberTimeline>(table->Compositions()));
+			};
+			for (size_t r = 0; r < nameR.size(); ++r) {
+				if (errorClaims[r]) {
+					errors.Publish(errorClaims[r], std::shared_ptr<const EndmemberTimeline::RatioErrors>(table->ErrorsOf(r)));
+				};
+			};
+			return table;
+		} catch (...) {
+			if (compositionsClaim) {
+				compositions.Abandon(key.Value(), compositionsClaim, std::current_exception());
+			};
+			for (size_t r = 0; r < nameR.size(); ++r) {
+				if (errorClaims[r]) {
+					errors.Abandon(errorKeys[r], errorClaims[r], std::current_exception());
+				};
+			};
+			throw;
+		};
+	};
+	std::vector<std::shared_ptr<const EndmemberTimeline::RatioErrors>> ratioErrors;
+	for (auto& entry : errorEntries) {
+		ratioErrors.push_back(entry.get());
+	};
+	return std::shared_ptr<const EndmemberTimeline>(compositionsEntry.get()->WithErrors(ratioErrors));
+};
+
+std::shared_ptr<const EndmemberBank> ReconManager::GetEndmemberBank(double tStart, double tEnd, double step) const {
+	size_t replicates = initConfig.GetOr<size_t>("EndmemberReplicates", 0);
+	if (replicates == 0) {
+		return nullptr;
+	};
+	//Replicates are drawn as the reconstruction reaches each time (see EndmemberBank)
+	std::cout << "ENDMEMBER RESAMPLE BANK: " << replicates << " REPLICATES FROM " << tStart << "Ma, EVERY " << step << "Myr" << std::endl;
+	return std::make_shared<const EndmemberBank>(*E, endmemberLock, Nmntr, Dmntr, tStart, tEnd, step, replicates, BootstrapSeed(), initConfig.GetOr<size_t>("BootstrapThreads", 0));
+};
+
+EndmemberState ReconManager::RecalculateEndmembers(double t) const {
+	std::lock_guard<std::mutex> guard(*endmemberLock);
+	E->RecalculateForTime(t);
+	return *E;
+};
+
+std::vector<RockDatabase> ReconManager::ExportEndmemberSamples(double t) const {
+	std::lock_guard<std::mutex> guard(*endmemberLock);
+	E->RecalculateForTime(t);
+	return E->ExportSamples();
+};
+
 #ifdef PYTHON_LIB
 std::vector<double> ReconManager::ForwardModelCalc(double t, boost::python::list p) const {
 	auto pVect = PyList2Vect<double>(p);
@@ -239,4 +649,8 @@ double ReconManager::ForwardModelCalc(double t, boost::python::list p, const std
 	auto pVect = PyList2Vect<double>(p);
 	return ForwardModelCalc(t, pVect, MemberOffset<RockSample, double>(RockSample::allElements[EL]));
 };
+
+void ReconManager::StreamToCallback(boost::python::object callback) {
+	AddResultsSink(std::make_shared<PythonResultsSink>(callback));
+};
 #endif
@@ -1,6 +1,21 @@
 #pragma once
 #include "reconCommon.h"
 #include "reconEndmembers.h"
+#include "reconResultsSink.h"
+#include "WRBCache.h"
+#include <memory>
+
+// Interface to a reconstruction which keeps refining its results in a background thread
+// NB: the background thread draws from its own random number streams, never from the global generator
+class ProgressiveRecon {
+public:
+	virtual void Start() = 0;
+	virtual void Stop() = 0;
+	virtual bool Running() const = 0;
+	virtual size_t Version() const = 0;
+	virtual std::string Snapshot() const = 0;
+	virtual ~ProgressiveRecon() {};
+};
 
 // Configuration structure to initialise reconstructions
 // 
@@ -13,25 +28,61 @@ struct ReconManager {
 	std::vector < DiscreteFunction >				errMF;
 	std::vector < std::string >						nameR;
 	double											kernelWidth;
-	~ReconManager() { delete E; };
+	~ReconManager() { progressive.reset(); delete E; };
 
 private:
 	DenseStringMap initConfig;
-	typedef std::string(*reconFptr)(const ReconManager&);
+	typedef ReconOutputs(*reconFptr)(const ReconManager&);
 	reconFptr execRecon;
+	std::shared_ptr<ProgressiveRecon> progressive;
+	std::shared_ptr<ResultsSinkList> sinks;
+	std::shared_ptr<MemoryResultsSink> memorySink;
+	WRBCache bootCache;
 	RockDatabase* parsedDB_Keller;
 	RockDatabase* parsedDB_nomorb;
+	//Serialises every use of E, which is recomputed in place for each time
+	std::shared_ptr<std::mutex> endmemberLock;
 
 	MemberOffset<RockSample, double> TranslateOffset(const std::string& sysName);
-
+	WRB_ErrorMode BootstrapErrorMode() const;
+	WRB_Replicates BootstrapReplicates() const;
+	WRB_Kernel BootstrapKernel() const;
+	uint64 BootstrapSeed() const;
+	//Cache key of a single-ratio bootstrap
+	uint64 BootstrapKey(const std::vector<double>& age, const std::vector<double>& a, const std::vector<double>& b, const WRB_Kernel& kernel, const WRB_Replicates& replicates, uint64 seed) const;
+	//Age, A & B lists of the shale database, restricted to samples where all three are finite
+	void ExtractBootstrapData(const MemberOffset<RockSample, double>& A, const MemberOffset<RockSample, double>& B, std::vector<double>& age, std::vector<double>& a, std::vector<double>& b);
+
+	//Bootstraps are looked up in (and added to) the on-disk cache given by "BootstrapCache" (default: none); it is never pruned
+	//"BootstrapSeed" fixes the seed of every bootstrap; otherwise it is drawn from the global random number generator
+	//"BootstrapErrors" selects how standard errors are computed: "Resample" (default) or "Analytic" (see WRB_ErrorMode)
+	//"BootstrapPrecision" makes the replicate count adaptive, between "BootstrapMinIter" & "BootstrapMaxIter" (see WRB_Replicates)
+	//"BootstrapBinWidth" (Myr) switches to the approximate, binned kernel sums (see WRB_Kernel)
 	WRB_Result GenerateBootstrapIMPL(const MemberOffset<RockSample, double>& A, const MemberOffset<RockSample, double>& B);
+	//Bootstraps several ratios together, sharing every resample (see WRB_MultiBootstrap); only cache misses are computed
+	std::vector<WRB_Result> GenerateBootstrapsIMPL(const std::vector<MemberOffset<RockSample, double>>& A, const std::vector<MemberOffset<RockSample, double>>& B);
 public:
+	//Changing the ratios or bootstraps stops the progressive reconstruction first (its background thread reads them)
 	void AddRatio(const std::string& RNAME, MemberOffset<RockSample, double> NOM, MemberOffset<RockSample, double> DNM);
 	size_t CountRatios() const;
 	void AddBootstrap(const WRB_Result& r);
 	size_t DataCountForBootstrap(const std::string& A, const std::string& B);
 
 	WRB_Result GenerateBootstrap(const std::string& A, const std::string& B);
+	std::vector<WRB_Result> GenerateBootstraps(const std::vector<std::string>& A, const std::vector<std::string>& B);
+	//Bootstraps A/B for every kernel width in the list (instead of BootstrapKernelWidth), sharing the resamples between widths (never binned)
+	std::vector<WRB_Result> GenerateBootstrapSweep(const std::string& A, const std::string& B, const std::vector<double>& kernelWidths);
+	//Leave-one-out cross-validation of the bootstrap kernel width for A/B (see WRB_CrossValidation)
+	//Columns: KernelWidth, CVScore
+	ResultsTable CrossValidateKernelWidth(const std::string& A, const std::string& B, const std::vector<double>& kernelWidths);
+	//Returns the width with the lowest cross-validation score
+	double SelectKernelWidth(const std::string& A, const std::string& B, const std::vector<double>& kernelWidths);
+	//Validation of the analytic standard errors: bootstraps A/B both ways on the same data (bypassing the cache)
+	//Columns: Age, BestFit, ResampleSE, AnalyticSE, Ratio (analytic / resampled)
+	ResultsTable CompareBootstrapErrors(const std::string& A, const std::string& B);
+	//Validation of the binned bootstrap: bootstraps A/B exactly & with bins of 'binWidth', from the same resamples (bypassing the cache)
+	//Columns: Age, BestFit, BinnedFit, StdError, BinnedStdError, FitError (|BinnedFit - BestFit| / StdError)
+	ResultsTable CompareBinnedBootstrap(const std::string& A, const std::string& B, double binWidth);
 
 	void GenerateAllBootstraps();
 	void ResetAllBootstraps();
@@ -45,8 +96,33 @@ public:
 	//Returns the configuration object that was used to initialise this ReconManager
 	const DenseStringMap& GetInitConfig() const { return initConfig; };
 
-	//Executes the reconstruction, returns output as a CSV string
+	//Executes the reconstruction, returns the output of the primary results processor as a CSV string
 	std::string RunReconstruction() const;
+	//Executes the reconstruction, returns the outputs of all results processors
+	ReconOutputs RunReconstructionAll() const;
+	//Executes the reconstruction, writes the output of each results processor to <pathPrefix>_<processor name>.hlt, returns the file names
+	std::vector<std::string> RunReconstructionToFiles(const std::string& pathPrefix) const;
+
+	//Starts a progressive reconstruction: returns a coarse preview as a CSV string, and keeps refining it in the background
+	std::string StartProgressiveReconstruction();
+	//Returns the latest results of the progressive reconstruction as a CSV string
+	std::string GetReconstructionSnapshot() const;
+	//Returns a counter which increases every time the progressive reconstruction publishes a new timestep
+	size_t GetSnapshotVersion() const;
+	//Returns true while the progressive reconstruction is still refining
+	bool IsRefining() const;
+	void StopProgressiveReconstruction();
+
+	//Results sinks receive every finished timestep while the reconstruction is still running (see ResultsSink)
+	//Returns null if no sinks have been requested
+	std::shared_ptr<ResultsSink> GetResultsSink() const;
+	void AddResultsSink(std::shared_ptr<ResultsSink> sink);
+	void ClearResultsSinks();
+	//Streams every timestep into <pathPrefix>_<processor name>.csv
+	void StreamToFile(const std::string& pathPrefix);
+	//Buffers every timestep in memory, until collected by DrainStream
+	void StreamToMemory();
+	ReconOutputs DrainStream();
 
 	//Run the forward mixing calculation, given a time and a proportion of endmembers
 	std::vector<double> ForwardModelCalc(double t, const std::vector<double>& p) const;
@@ -55,6 +131,18 @@ public:
 	std::string GetEndmemberName(size_t idx) const;
 	size_t GetEndmemberCount() const;
 
+	//Endmember states on the grid tStart, tStart - step, ... (above tEnd), shared (read-only) with every ReconManager in the
+	//process that has the same endmember configuration, endmember databases & ratios
+	//Bootstrapped endmembers are random, so their tables are not shared
+	std::shared_ptr<const EndmemberTimeline> GetEndmemberTimeline(double tStart, double tEnd, double step) const;
+	//Bootstrap replicates of the endmembers on the same grid (for the MCMC to integrate over), or null unless EndmemberReplicates is set
+	//Every call draws a new bank
+	std::shared_ptr<const EndmemberBank> GetEndmemberBank(double tStart, double tEnd, double step) const;
+	//Endmember state at any time t, recomputed (one thread at a time)
+	EndmemberState RecalculateEndmembers(double t) const;
+	//Samples which make up each endmember at time t
+	std::vector<RockDatabase> ExportEndmemberSamples(double t) const;
+
 #ifdef PYTHON_LIB
 	ReconManager(boost::python::dict D,
 				 const std::string& DB = "") : ReconManager(DenseStringMap(D), DB) {};
@@ -62,19 +150,18 @@ public:
 	std::vector<double> ForwardModelCalc(double t, boost::python::list p) const;
 	double ForwardModelCalc(double t, boost::python::list p, const std::string& EL) const;
 
+	//Calls callback(processor name, {column: value}) for every finished timestep
+	void StreamToCallback(boost::python::object callback);
 #endif
 };
 
 //Forward definitions for reconstruction functions
 namespace MCMCRecon {
-	std::string RunMarkovModel_2M(const ReconManager& RM);
-	std::string RunMarkovModel_3M(const ReconManager& RM);
-	std::string RunMarkovModel_4M(const ReconManager& RM);
-	std::string RunMarkovModel_5M(const ReconManager& RM);
-	std::string RunMarkovModel_2M_Ratios(const ReconManager& RM);
-	std::string RunMarkovModel_3M_Ratios(const ReconManager& RM);
-	std::string RunMarkovModel_4M_Ratios(const ReconManager& RM);
-	std::string RunMarkovModel_5M_Ratios(const ReconManager& RM);
+	ReconOutputs RunMarkovModel_2M(const ReconManager& RM);
+	ReconOutputs RunMarkovModel_3M(const ReconManager& RM);
+	ReconOutputs RunMarkovModel_4M(const ReconManager& RM);
+	ReconOutputs RunMarkovModel_5M(const ReconManager& RM);
+	ProgressiveRecon* CreateProgressiveMarkovModel(const ReconManager& RM);
 };
 namespace MatrixRecon {
 	std::string RunModel_2M(const ReconManager& RM);
@@ -8,9 +8,132 @@ protected:
 	ResultsProcessor_Generic(const DenseStringMap& conf);
 };
 
+//Interface of all reconstruction results processors for N endmembers
+//Every processor is fed the same MCMC chain of each timestep, and produces its own table of results
+template<int N>
+class ResultsProcessor : public ResultsProcessor_Generic {
+	std::shared_ptr<ResultsSink> sink;
+	std::string sinkName;
+protected:
+	ResultsProcessor(const DenseStringMap& conf) : ResultsProcessor_Generic(conf) {};
+
+	bool Streaming() const {
+		return (bool)sink;
+	};
+	//Pushes the rows of a finished timestep into the results sink
+	void Publish(const ResultsTable& rows) {
+		sink->Push(sinkName, rows);
+	};
+public:
+	//Streams every finished timestep into 'S', under the name 'name'
+	void StreamTo(std::shared_ptr<ResultsSink> S, const std::string& name) {
+		sink = S;
+		sinkName = name;
+	};
+	virtual void Record(double t, const MixState<N>& bestFit, const std::vector<MixState<N>>& states, const EndmemberState& e, size_t skip_records = 0, double accept_ratio = 0.0) = 0;
+	virtual ResultsTable Results2Table() = 0;
+	virtual ResultsProcessor<N>* Clone() const = 0;
+	std::string Results2CSV() {
+		return Results2Table().ToCSV();
+	};
+	virtual ~ResultsProcessor() {};
+};
+
+//Projects the post-burn-in MCMC states onto the mixture concentrations of a fixed list of K elements
+//The endmember concentrations are packed into a dense Ne x K matrix once per timestep, and the (states x Ne) chain
+//is multiplied through it in blocks of columns (stored column-major, so every element's posterior is contiguous).
+template<int N>
+class PosteriorProjection {
+	//Upper bound on the size of the projected block, in doubles
+	static const size_t BLOCK_BUDGET = 1 << 22;
+	//Number of states projected together, so that a tile of the output stays in cache
+	static const size_t ROW_TILE = 256;
+
+	std::vector<DataOffset<RockSample, double>> elements;
+	std::vector<double> M;
+	std::vector<double> block;
+	size_t rows;
+	size_t k0;
+public:
+	size_t Columns() const { return elements.size(); };
+	size_t Rows() const { return rows; };
+	//Number of columns which fit into one projected block
+	size_t BlockColumns() const { return std::max<size_t>(1, BLOCK_BUDGET / std::max<size_t>(1, rows)); };
+
+	//Packs the concentrations of every element in every endmember into the Ne x K matrix
+	void LoadEndmembers(const EndmemberState& e) {
+		size_t K = elements.size();
+		M.resize(N * K);
+		for (size_t idx = 0; idx < N; ++idx) {
+			for (size_t k = 0; k < K; ++k) {
+				M[idx * K + k] = elements[k](e.E[idx]);
+			};
+		};
+	};
+
+	//Sets the number of rows (post-burn-in states) of the following projections
+	void SetRows(const std::vector<MixState<N>>& states, size_t skip_records) {
+		rows = (states.size() > skip_records) ? states.size() - skip_records : 0;
+	};
+
+	//Projects the states onto the element columns [from, to)
+	void Project(const std::vector<MixState<N>>& states, size_t skip_records, size_t from, size_t to) {
+		size_t K = elements.size();
+		size_t cols = to - from;
+		k0 = from;
+		block.resize(rows * cols);
+		for (size_t r0 = 0; r0 < rows; r0 += ROW_TILE) {
+			size_t r1 = std::min(rows, r0 + ROW_TILE);
+			for (size_t k = from; k < to; ++k) {
+				double m[N];
+				for (size_t idx = 0; idx < N; ++idx) {
+					m[idx] = M[idx * K + k];
+				};
+				double* out = &block[(k - from) * rows];
+				for (size_t r = r0; r < r1; ++r) {
+					const MixState<N>& S = states[skip_records + r];
+					double c = 0.0;
+					for (size_t idx = 0; idx < N; ++idx) {
+						c += S[idx] * m[idx];
+					};
+					out[r] = c;
+				};
+			};
+		};
+	};
+
+	//Concentrations of element k in every state (k must lie in the last projected range)
+	//The column may be freely reordered by the caller, e.g. for percentile selection
+	double* Column(size_t k) {
+		return &block[(k - k0) * rows];
+	};
+
+	//Concentrations of element k in a single mixing state
+	double Concentration(const MixState<N>& S, size_t k) const {
+		double c = 0.0;
+		for (size_t idx = 0; idx < N; ++idx) {
+			c += S[idx] * M[idx * elements.size() + k];
+		};
+		return c;
+	};
+
+	PosteriorProjection(const std::vector<DataOffset<RockSample, double>>& el) : elements(el), rows(0), k0(0) {};
+	//The projected block is scratch space, and is not copied along with the projection
+	PosteriorProjection(const PosteriorProjection& o) : elements(o.elements), M(o.M), rows(o.rows), k0(o.k0) {};
+	PosteriorProjection& operator=(const PosteriorProjection& o) {
+		elements = o.elements;
+		M = o.M;
+		rows = o.rows;
+		k0 = o.k0;
+		block.clear();
+		return *this;
+	};
+};
+
 //Reconstruction results processor: Only prints confidence intervals for endmembers
 template<int N>
-class ResultsProcessor_Endmembers : public ResultsProcessor_Generic {
+class ResultsProcessor_Endmembers : public ResultsProcessor<N> {
+	using ResultsProcessor_Generic::logAcceptanceRatio;
 	struct EarthState {
 		double time;
 		double mcmc_acceptance;
@@ -23,7 +146,7 @@ class ResultsProcessor_Endmembers : public ResultsProcessor_Generic {
 	std::vector<EarthState> V;
 	const ReconManager* rm;
 public:
-	void Record(double t, const MixState<N>& bestFit, const std::vector<MixState<N>>& states, const Endmembers& e, size_t skip_records = 0, double accept_ratio = 0.0) {
+	void Record(double t, const MixState<N>& bestFit, const std::vector<MixState<N>>& states, const EndmemberState& e, size_t skip_records = 0, double accept_ratio = 0.0) override {
 		if ((!logAcceptanceRatio) || (accept_ratio > 0)) {
 			EarthState es;
 			es.time = t;
@@ -50,55 +173,83 @@ public:
 					E.second.DataR(es.bestFit) += es.mean[idx] * E.second.Data(e.E[idx]);
 				};
 			};
-			V.push_back(es);
+			//Later records of the same timestep replace earlier ones
+			auto it = std::find_if(V.begin(), V.end(), [t](const EarthState& o) { return o.time == t; });
+			if (it != V.end()) {
+				*it = es;
+			} else {
+				V.push_back(es);
+			};
+			if (this->Streaming()) {
+				ResultsTable row = Header();
+				AppendRow(row, es);
+				this->Publish(row);
+			};
 		};
 	};
 
-	std::string Results2CSV() {
-		std::stringstream ss;
-		ss << "TIME(/MYR),";
+	ResultsTable Header() const {
+		ResultsTable T;
+		T.AddColumn("TIME(/MYR)");
 		//Generate column names for endmembers
 		for (size_t idx = 0; idx < N; ++idx) {
-			ss << rm->GetEndmemberName(idx) << ",";
+			T.AddColumn(rm->GetEndmemberName(idx));
 		};
 		const char* suffix[] = {"025", "975"};
 		for (size_t idx = 0; idx < N; ++idx) {
 			for (size_t i = 0; i < ARRAY_SIZE(suffix); ++i) {
-				ss << "ERR_" << rm->GetEndmemberName(idx) << suffix[i] << ",";
+				T.AddColumn("ERR_" + rm->GetEndmemberName(idx) + suffix[i]);
 			};
 		};
 		if (logAcceptanceRatio) {
-			ss << "MCMC_ACCEPT%,";
+			T.AddColumn("MCMC_ACCEPT%");
+		};
+		for (auto& E : RockSample::allElements) {
+			T.AddColumn(E.first, true);
+		};
+		return T;
+	};
+
+	void AppendRow(ResultsTable& T, const EarthState& es) const {
+		size_t c = 0;
+		T[c++].push_back(es.time);
+		for (size_t idx = 0; idx < N; ++idx) {
+			T[c++].push_back(100 * es.mean[idx]);
+		};
+		for (size_t idx = 0; idx < N; ++idx) {
+			T[c++].push_back(100 * es.p025[idx]);
+			T[c++].push_back(100 * es.p975[idx]);
+		};
+		if (logAcceptanceRatio) {
+			T[c++].push_back(100 * es.mcmc_acceptance);
 		};
 		for (auto& E : RockSample::allElements) {
-			ss << E.first << ",";
+			T[c++].push_back(E.second.Data(es.bestFit));
 		};
-		ss << std::endl;
+	};
+
+	ResultsTable Results2Table() override {
+		//Timesteps may have been recorded out of order (e.g. by the adaptive timeline)
+		std::stable_sort(V.begin(), V.end(), [](const EarthState& a, const EarthState& b) { return a.time > b.time; });
+		ResultsTable T = Header();
+		T.Reserve(V.size());
 		for (const auto& es : V) {
-			ss << es.time << ",";
-			for (size_t idx = 0; idx < N; ++idx) {
-				ss << 100 * es.mean[idx] << ",";
-			};
-			for (size_t idx = 0; idx < N; ++idx) {
-				ss << 100 * es.p025[idx] << "," << 100 * es.p975[idx] << ",";
-			};
-			if (logAcceptanceRatio) {
-				ss << 100 * es.mcmc_acceptance << ",";
-			};
-			for (auto& E : RockSample::allElements) {
-				ss << std::to_string(E.second.Data(es.bestFit)) << ",";
-			};
-			ss << std::endl;
+			AppendRow(T, es);
 		};
-		return ss.str();
+		return T;
+	};
+
+	ResultsProcessor<N>* Clone() const override {
+		return new ResultsProcessor_Endmembers<N>(*this);
 	};
 
-	ResultsProcessor_Endmembers(const ReconManager& RM) : ResultsProcessor_Generic(RM.GetInitConfig()), rm(&RM) {};
+	ResultsProcessor_Endmembers(const ReconManager& RM) : ResultsProcessor<N>(RM.GetInitConfig()), rm(&RM) {};
 };
 
 //Reconstruction results processor: Prints confidence intervals for all ratios in analysis
 template<int N>
-class ResultsProcessor_Ratios : public ResultsProcessor_Generic {
+class ResultsProcessor_Ratios : public ResultsProcessor<N> {
+	using ResultsProcessor_Generic::logAcceptanceRatio;
 	struct EarthState {
 		double time;
 		double mcmc_acceptance;
@@ -111,72 +262,104 @@ class ResultsProcessor_Ratios : public ResultsProcessor_Generic {
 	std::vector<std::string> logRatioNames;
 	std::vector<DataOffset<RockSample, double>> logRatioA;
 	std::vector<DataOffset<RockSample, double>> logRatioB;
+	PosteriorProjection<N> projection;
+
+	static std::vector<DataOffset<RockSample, double>> InterleaveRatioElements(const std::vector<DataOffset<RockSample, double>>& A,
+																			   const std::vector<DataOffset<RockSample, double>>& B) {
+		std::vector<DataOffset<RockSample, double>> el;
+		for (size_t i = 0; i < A.size(); ++i) {
+			el.push_back(A[i]);
+			el.push_back(B[i]);
+		};
+		return el;
+	};
 public:
-	void Record(double t, const MixState<N>& bestFit, const std::vector<MixState<N>>& states, const Endmembers& e, size_t skip_records = 0, double accept_ratio = 0.0) {
+	void Record(double t, const MixState<N>& bestFit, const std::vector<MixState<N>>& states, const EndmemberState& e, size_t skip_records = 0, double accept_ratio = 0.0) override {
 		if ((!logAcceptanceRatio) || (accept_ratio > 0)) {
 			EarthState es;
 			es.time = t;
 			es.mcmc_acceptance = accept_ratio;
 			std::vector<double> tempVec;
-			tempVec.reserve(states.size());
 
-			//Given a mixing state and a member pointer, computes the concentration of that element in the final mixture
-			auto ELEMENT_CONCENTRATION = [&](const MixState<N>& MIXSTATE, const DataOffset<RockSample, double> DAT) {
-				double conc = 0.0;
-				for (size_t idx = 0; idx < N; ++idx) {
-					conc += MIXSTATE[idx] * DAT(e.E[idx]);
-				};
-				return conc;
+			//Ratio i is computed from projected columns 2i (numerator) and 2i+1 (denominator)
+			projection.LoadEndmembers(e);
+			projection.SetRows(states, skip_records);
+			if (projection.Rows() == 0) {
+				return;
 			};
-
-			auto RATIO_VALUE = [&](const MixState<N>& MIXSTATE,
-								   const DataOffset<RockSample, double> A,
-								   const DataOffset<RockSample, double> B) {
-				return ELEMENT_CONCENTRATION(MIXSTATE, A) / ELEMENT_CONCENTRATION(MIXSTATE, B); };
-
-			//Record percentiles & best fit of every ratio
+			tempVec.resize(projection.Rows());
 			for (size_t i = 0; i < logRatioNames.size(); ++i) {
-				auto A = logRatioA[i];
-				auto B = logRatioB[i];
-				tempVec.clear();
-				for (size_t mc = skip_records; mc < states.size(); ++mc) {
-					tempVec.push_back(RATIO_VALUE(states[mc], A, B));
+				projection.Project(states, skip_records, 2 * i, 2 * i + 2);
+				const double* A = projection.Column(2 * i);
+				const double* B = projection.Column(2 * i + 1);
+				for (size_t r = 0; r < tempVec.size(); ++r) {
+					tempVec[r] = A[r] / B[r];
 				};
-				std::sort(tempVec.begin(), tempVec.end());
-				es.p025.push_back(SortedVectorPercentile(tempVec, 2.5));
-				es.p975.push_back(SortedVectorPercentile(tempVec, 97.5));
-				es.bestFit.push_back(RATIO_VALUE(bestFit, A, B));
+				es.p025.push_back(SelectVectorPercentile(tempVec, 2.5));
+				es.p975.push_back(SelectVectorPercentile(tempVec, 97.5));
+				es.bestFit.push_back(projection.Concentration(bestFit, 2 * i) / projection.Concentration(bestFit, 2 * i + 1));
+			};
+			//Later records of the same timestep replace earlier ones
+			auto it = std::find_if(V.begin(), V.end(), [t](const EarthState& o) { return o.time == t; });
+			if (it != V.end()) {
+				*it = es;
+			} else {
+				V.push_back(es);
+			};
+			if (this->Streaming()) {
+				ResultsTable row = Header();
+				AppendRow(row, es);
+				this->Publish(row);
 			};
-			V.push_back(es);
 		};
 	};
 
-	std::string Results2CSV() {
-		std::stringstream ss;
-		ss << "TIME(/MYR),";
+	ResultsTable Header() const {
+		ResultsTable T;
+		T.AddColumn("TIME(/MYR)");
 		if (logAcceptanceRatio) {
-			ss << "MCMC_ACCEPT%,";
+			T.AddColumn("MCMC_ACCEPT%");
 		};
 		for (const auto& E : logRatioNames) {
-			ss << E + "_025," << E << "," << E + "_975,";
+			T.AddColumn(E + "_025", true);
+			T.AddColumn(E, true);
+			T.AddColumn(E + "_975", true);
 		};
-		ss << std::endl;
+		return T;
+	};
+
+	void AppendRow(ResultsTable& T, const EarthState& es) const {
+		size_t c = 0;
+		T[c++].push_back(es.time);
+		if (logAcceptanceRatio) {
+			T[c++].push_back(100 * es.mcmc_acceptance);
+		};
+		for (size_t i = 0; i < logRatioNames.size(); ++i) {
+			T[c++].push_back(es.p025[i]);
+			T[c++].push_back(es.bestFit[i]);
+			T[c++].push_back(es.p975[i]);
+		};
+	};
+
+	ResultsTable Results2Table() override {
+		//Timesteps may have been recorded out of order (e.g. by the adaptive timeline)
+		std::stable_sort(V.begin(), V.end(), [](const EarthState& a, const EarthState& b) { return a.time > b.time; });
+		ResultsTable T = Header();
+		T.Reserve(V.size());
 		for (const auto& es : V) {
-			ss << es.time << ",";
-			if (logAcceptanceRatio) {
-				ss << 100 * es.mcmc_acceptance << ",";
-			};
-			for (size_t i = 0; i < logRatioNames.size(); ++i) {
-				ss << std::to_string(es.p025[i]) << ",";
-				ss << std::to_string(es.bestFit[i]) << ",";
-				ss << std::to_string(es.p975[i]) << ",";
-			};
-			ss << std::endl;
+			AppendRow(T, es);
 		};
-		return ss.str();
+		return T;
 	};
 
-	ResultsProcessor_Ratios(const ReconManager& RM) : ResultsProcessor_Generic(RM.GetInitConfig()) {
+	ResultsProcessor<N>* Clone() const override {
+		return new ResultsProcessor_Ratios<N>(*this);
+	};
+
+	ResultsProcessor_Ratios(const ReconManager& RM) : ResultsProcessor<N>(RM.GetInitConfig()), projection({}) {
+		if (!RM.GetInitConfig().Contains("detailedRatioPrinter")) {
+			throw std::runtime_error("The Ratios results processor requires a detailedRatioPrinter list");
+		};
 		for (const auto& Rstr : RM.GetInitConfig()["detailedRatioPrinter"]) {
 			size_t sep = Rstr.find_first_of('/');
 			std::string Astr = Rstr.substr(0, sep);
@@ -188,5 +371,329 @@ public:
 			logRatioA.push_back(A);
 			logRatioB.push_back(B);
 		};
+		projection = PosteriorProjection<N>(InterleaveRatioElements(logRatioA, logRatioB));
+	};
+};
+
+//Reconstruction results processor: Prints confidence intervals for the concentration of every element in the mixture
+//The element list may be restricted with the "elementBandList" config key
+template<int N>
+class ResultsProcessor_Elements : public ResultsProcessor<N> {
+	using ResultsProcessor_Generic::logAcceptanceRatio;
+	struct EarthState {
+		double time;
+		std::vector<double> p025;
+		std::vector<double> p500;
+		std::vector<double> p975;
+	};
+
+	std::vector<EarthState> V;
+	std::vector<std::string> elementNames;
+	PosteriorProjection<N> projection;
+
+	static std::vector<DataOffset<RockSample, double>> SelectElements(const DenseStringMap& conf, std::vector<std::string>& names) {
+		std::vector<DataOffset<RockSample, double>> el;
+		if (conf.Contains("elementBandList")) {
+			for (const auto& Estr : conf["elementBandList"]) {
+				names.push_back(Estr);
+				el.push_back((MemberOffset<RockSample, double>)RockSample::allElements[Estr]);
+			};
+		} else {
+			for (auto& E : RockSample::allElements) {
+				names.push_back(E.first);
+				el.push_back(E.second);
+			};
+		};
+		return el;
+	};
+public:
+	void Record(double t, const MixState<N>& bestFit, const std::vector<MixState<N>>& states, const EndmemberState& e, size_t skip_records = 0, double accept_ratio = 0.0) override {
+		if ((!logAcceptanceRatio) || (accept_ratio > 0)) {
+			EarthState es;
+			es.time = t;
+			projection.LoadEndmembers(e);
+			projection.SetRows(states, skip_records);
+			if (projection.Rows() == 0) {
+				return;
+			};
+			for (size_t k0 = 0; k0 < projection.Columns(); k0 += projection.BlockColumns()) {
+				size_t k1 = std::min(projection.Columns(), k0 + projection.BlockColumns());
+				projection.Project(states, skip_records, k0, k1);
+				for (size_t k = k0; k < k1; ++k) {
+					//Select percentiles in place, the projected column is not needed afterwards
+					double* col = projection.Column(k);
+					es.p025.push_back(SelectRangePercentile(col, projection.Rows(), 2.5));
+					es.p500.push_back(SelectRangePercentile(col, projection.Rows(), 50.0));
+					es.p975.push_back(SelectRangePercentile(col, projection.Rows(), 97.5));
+				};
+			};
+			auto it = std::find_if(V.begin(), V.end(), [t](const EarthState& o) { return o.time == t; });
+			if (it != V.end()) {
+				*it = es;
+			} else {
+				V.push_back(es);
+			};
+			if (this->Streaming()) {
+				ResultsTable row = Header();
+				AppendRow(row, es);
+				this->Publish(row);
+			};
+		};
+	};
+
+	ResultsTable Header() const {
+		ResultsTable T;
+		T.AddColumn("TIME(/MYR)");
+		for (const auto& E : elementNames) {
+			T.AddColumn(E + "_025", true);
+			T.AddColumn(E, true);
+			T.AddColumn(E + "_975", true);
+		};
+		return T;
+	};
+
+	void AppendRow(ResultsTable& T, const EarthState& es) const {
+		size_t c = 0;
+		T[c++].push_back(es.time);
+		for (size_t i = 0; i < elementNames.size(); ++i) {
+			T[c++].push_back(es.p025[i]);
+			T[c++].push_back(es.p500[i]);
+			T[c++].push_back(es.p975[i]);
+		};
+	};
+
+	ResultsTable Results2Table() override {
+		std::stable_sort(V.begin(), V.end(), [](const EarthState& a, const EarthState& b) { return a.time > b.time; });
+		ResultsTable T = Header();
+		T.Reserve(V.size());
+		for (const auto& es : V) {
+			AppendRow(T, es);
+		};
+		return T;
+	};
+
+	ResultsProcessor<N>* Clone() const override {
+		return new ResultsProcessor_Elements<N>(*this);
+	};
+
+	ResultsProcessor_Elements(const ReconManager& RM)
+		: ResultsProcessor<N>(RM.GetInitConfig()), projection(SelectElements(RM.GetInitConfig(), elementNames)) {};
+};
+
+//Reconstruction results processor: Prints MCMC convergence diagnostics for every endmember
+//ESS is the effective sample size (batch means estimate), GEWEKE the z-score of the mean of the first 10% of the chain against the last 50%
+template<int N>
+class ResultsProcessor_Diagnostics : public ResultsProcessor<N> {
+	struct Diagnostic {
+		double mean;
+		double stdev;
+		double ess;
+		double geweke;
+	};
+	struct EarthState {
+		double time;
+		double mcmc_acceptance;
+		size_t samples;
+		Diagnostic d[N];
+	};
+
+	std::vector<EarthState> V;
+	const ReconManager* rm;
+
+	static void MeanAndVariance(const std::vector<MixState<N>>& states, size_t idx, size_t from, size_t to, double& mean, double& var) {
+		mean = 0.0;
+		var = 0.0;
+		for (size_t mc = from; mc < to; ++mc) {
+			mean += states[mc][idx];
+		};
+		mean /= (double)(to - from);
+		for (size_t mc = from; mc < to; ++mc) {
+			var += (states[mc][idx] - mean) * (states[mc][idx] - mean);
+		};
+		var /= (double)std::max<size_t>(1, to - from - 1);
+	};
+public:
+	void Record(double t, const MixState<N>& bestFit, const std::vector<MixState<N>>& states, const EndmemberState& e, size_t skip_records = 0, double accept_ratio = 0.0) override {
+		if (skip_records >= states.size()) {
+			return;
+		};
+		EarthState es;
+		es.time = t;
+		es.mcmc_acceptance = accept_ratio;
+		es.samples = states.size() - skip_records;
+		size_t batchSz = std::max<size_t>(1, (size_t)std::sqrt((double)es.samples));
+		size_t batches = es.samples / batchSz;
+		for (size_t idx = 0; idx < N; ++idx) {
+			Diagnostic& D = es.d[idx];
+			double var;
+			MeanAndVariance(states, idx, skip_records, states.size(), D.mean, var);
+			D.stdev = std::sqrt(var);
+
+			//Batch means: the variance of the batch means approximates var/ESS * batchSz
+			double bmVar = 0.0;
+			for (size_t b = 0; b < batches; ++b) {
+				double bm = 0.0;
+				for (size_t mc = skip_records + b * batchSz; mc < skip_records + (b + 1) * batchSz; ++mc) {
+					bm += states[mc][idx];
+				};
+				bm /= (double)batchSz;
+				bmVar += (bm - D.mean) * (bm - D.mean);
+			};
+			bmVar = (batches > 1) ? (batchSz * bmVar / (double)(batches - 1)) : 0.0;
+			D.ess = (bmVar > 0.0) ? std::min((double)es.samples, es.samples * var / bmVar) : (double)es.samples;
+
+			double meanA, varA, meanB, varB;
+			size_t splitA = skip_records + es.samples / 10;
+			size_t splitB = skip_records + es.samples / 2;
+			if ((splitA > skip_records + 1) && (states.size() > splitB + 1)) {
+				MeanAndVariance(states, idx, skip_records, splitA, meanA, varA);
+				MeanAndVariance(states, idx, splitB, states.size(), meanB, varB);
+				//Autocorrelation is accounted for by shrinking both segments to their effective sizes
+				double effFrac = D.ess / es.samples;
+				double se = std::sqrt(varA / (effFrac * (splitA - skip_records)) + varB / (effFrac * (states.size() - splitB)));
+				D.geweke = (se > 0.0) ? (meanA - meanB) / se : 0.0;
+			} else {
+				D.geweke = NAN;
+			};
+		};
+		auto it = std::find_if(V.begin(), V.end(), [t](const EarthState& o) { return o.time == t; });
+		if (it != V.end()) {
+			*it = es;
+		} else {
+			V.push_back(es);
+		};
+		if (this->Streaming()) {
+			ResultsTable row = Header();
+			AppendRow(row, es);
+			this->Publish(row);
+		};
+	};
+
+	ResultsTable Header() const {
+		ResultsTable T;
+		T.AddColumn("TIME(/MYR)");
+		T.AddColumn("MCMC_ACCEPT%");
+		T.AddColumn("SAMPLES");
+		const char* suffix[] = {"MEAN", "SD", "ESS", "GEWEKE"};
+		for (size_t idx = 0; idx < N; ++idx) {
+			for (size_t i = 0; i < ARRAY_SIZE(suffix); ++i) {
+				T.AddColumn(std::string(suffix[i]) + "_" + rm->GetEndmemberName(idx));
+			};
+		};
+		return T;
+	};
+
+	void AppendRow(ResultsTable& T, const EarthState& es) const {
+		size_t c = 0;
+		T[c++].push_back(es.time);
+		T[c++].push_back(100 * es.mcmc_acceptance);
+		T[c++].push_back((double)es.samples);
+		for (size_t idx = 0; idx < N; ++idx) {
+			T[c++].push_back(100 * es.d[idx].mean);
+			T[c++].push_back(100 * es.d[idx].stdev);
+			T[c++].push_back(es.d[idx].ess);
+			T[c++].push_back(es.d[idx].geweke);
+		};
+	};
+
+	ResultsTable Results2Table() override {
+		std::stable_sort(V.begin(), V.end(), [](const EarthState& a, const EarthState& b) { return a.time > b.time; });
+		ResultsTable T = Header();
+		T.Reserve(V.size());
+		for (const auto& es : V) {
+			AppendRow(T, es);
+		};
+		return T;
+	};
+
+	ResultsProcessor<N>* Clone() const override {
+		return new ResultsProcessor_Diagnostics<N>(*this);
+	};
+
+	ResultsProcessor_Diagnostics(const ReconManager& RM) : ResultsProcessor<N>(RM.GetInitConfig()), rm(&RM) {};
+};
+
+//Creates a results processor by name
+template<int N>
+ResultsProcessor<N>* CreateResultsProcessor(const std::string& name, const ReconManager& RM) {
+	if (name == "Endmembers") {
+		return new ResultsProcessor_Endmembers<N>(RM);
+	} else if (name == "Ratios") {
+		return new ResultsProcessor_Ratios<N>(RM);
+	} else if (name == "Elements") {
+		return new ResultsProcessor_Elements<N>(RM);
+	} else if (name == "Diagnostics") {
+		return new ResultsProcessor_Diagnostics<N>(RM);
+	};
+	throw std::runtime_error("Unrecognised results processor '" + name + "'");
+};
+
+//Feeds every recorded timestep to a list of results processors, so that all outputs come from a single MCMC run
+//The list is given by the "resultsProcessors" config key; by default, only ratios are printed when detailedRatioPrinter is set, and endmembers otherwise.
+//The first processor in the list is the primary output.
+template<int N>
+class ResultsProcessorSet {
+	std::vector<std::string> names;
+	std::vector<ResultsProcessor<N>*> P;
+public:
+	//Streams every processor into 'S' (under its own name) instead of the results sink of the ReconManager
+	void StreamTo(std::shared_ptr<ResultsSink> S) {
+		for (size_t i = 0; i < P.size(); ++i) {
+			P[i]->StreamTo(S, names[i]);
+		};
+	};
+
+	void Record(double t, const MixState<N>& bestFit, const std::vector<MixState<N>>& states, const EndmemberState& e, size_t skip_records = 0, double accept_ratio = 0.0) {
+		for (auto* p : P) {
+			p->Record(t, bestFit, states, e, skip_records, accept_ratio);
+		};
+	};
+
+	std::string Results2CSV() {
+		return P.front()->Results2CSV();
+	};
+
+	ReconOutputs AllResults2Table() {
+		ReconOutputs out;
+		for (size_t i = 0; i < P.size(); ++i) {
+			out.push_back(std::make_pair(names[i], P[i]->Results2Table()));
+		};
+		return out;
+	};
+
+	ResultsProcessorSet(const ReconManager& RM) {
+		const DenseStringMap& conf = RM.GetInitConfig();
+		if (conf.Contains("resultsProcessors")) {
+			names = conf["resultsProcessors"];
+		} else {
+			names.push_back(conf.Contains("detailedRatioPrinter") ? "Ratios" : "Endmembers");
+		};
+		if (names.empty()) {
+			throw std::runtime_error("No results processors requested");
+		};
+		try {
+			for (const auto& name : names) {
+				P.push_back(CreateResultsProcessor<N>(name, RM));
+				if (RM.GetResultsSink()) {
+					P.back()->StreamTo(RM.GetResultsSink(), name);
+				};
+			};
+		} catch (...) {
+			for (auto* p : P) {
+				delete p;
+			};
+			throw;
+		};
+	};
+	ResultsProcessorSet(const ResultsProcessorSet& o) : names(o.names) {
+		for (auto* p : o.P) {
+			P.push_back(p->Clone());
+		};
+	};
+	ResultsProcessorSet& operator=(const ResultsProcessorSet&) = delete;
+	~ResultsProcessorSet() {
+		for (auto* p : P) {
+			delete p;
+		};
 	};
 };
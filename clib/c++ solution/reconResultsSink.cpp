@@ -0,0 +1,104 @@
+#include "stdafx.h"
+#include "reconResultsSink.h"
+
+void ResultsSinkList::Add(std::shared_ptr<ResultsSink> sink) {
+	std::lock_guard<std::mutex> guard(lock);
+	sinks.push_back(sink);
+};
+
+void ResultsSinkList::Clear() {
+	//The sinks are released outside of the lock (a Python sink takes the GIL as it goes)
+	std::vector<std::shared_ptr<ResultsSink>> old;
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		old.swap(sinks);
+	};
+};
+
+bool ResultsSinkList::Empty() const {
+	std::lock_guard<std::mutex> guard(lock);
+	return sinks.empty();
+};
+
+void ResultsSinkList::Push(const std::string& processor, const ResultsTable& rows) {
+	//Sinks are called on a copy of the list, without holding the lock: a Python sink waits for the GIL,
+	//whose holder may be waiting for the lock (e.g. to clear the sinks)
+	std::vector<std::shared_ptr<ResultsSink>> current;
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		current = sinks;
+	};
+	for (auto& S : current) {
+		S->Push(processor, rows);
+	};
+};
+
+void FileResultsSink::Push(const std::string& processor, const ResultsTable& rows) {
+	std::lock_guard<std::mutex> guard(lock);
+	auto it = files.find(processor);
+	if (it == files.end()) {
+		std::string path = pathPrefix + "_" + processor + ".csv";
+		std::ifstream probe(path);
+		bool fresh = !probe.good() || (probe.peek() == std::ifstream::traits_type::eof());
+		probe.close();
+		it = files.insert(std::make_pair(processor, std::ofstream(path, std::ios::app))).first;
+		if (!it->second) {
+			throw std::runtime_error("Cannot open '" + path + "' for writing");
+		};
+		if (fresh) {
+			it->second << rows.HeaderCSV();
+		};
+	};
+	it->second << rows.RowsCSV();
+	it->second.flush();
+};
+
+void MemoryResultsSink::Push(const std::string& processor, const ResultsTable& rows) {
+	std::lock_guard<std::mutex> guard(lock);
+	for (auto& P : pending) {
+		if (P.first == processor) {
+			P.second.Append(rows);
+			return;
+		};
+	};
+	pending.push_back(std::make_pair(processor, rows));
+};
+
+std::vector<std::pair<std::string, ResultsTable>> MemoryResultsSink::Drain() {
+	std::lock_guard<std::mutex> guard(lock);
+	std::vector<std::pair<std::string, ResultsTable>> out;
+	out.swap(pending);
+	return out;
+};
+
+#ifdef PYTHON_LIB
+PythonResultsSink::PythonResultsSink(boost::python::object cb) : callback(cb) {
+#if PY_VERSION_HEX < 0x03070000
+	//Make sure the GIL exists before a background thread asks for it
+	PyEval_InitThreads();
+#endif
+};
+
+PythonResultsSink::~PythonResultsSink() {
+	PyGILState_STATE gil = PyGILState_Ensure();
+	callback = boost::python::object();
+	PyGILState_Release(gil);
+};
+
+void PythonResultsSink::Push(const std::string& processor, const ResultsTable& rows) {
+	PyGILState_STATE gil = PyGILState_Ensure();
+	try {
+		for (size_t r = 0; r < rows.Rows(); ++r) {
+			boost::python::dict row;
+			for (size_t c = 0; c < rows.Columns(); ++c) {
+				row[rows.GetColumn(c).name] = rows[c][r];
+			};
+			callback(processor, row);
+		};
+	} catch (const boost::python::error_already_set&) {
+		//Errors in the callback must not abort the reconstruction
+		PyErr_Print();
+	};
+	PyGILState_Release(gil);
+};
+#endif
@@ -0,0 +1,59 @@
+#pragma once
+#include "reconResultsTable.h"
+#include <map>
+#include <mutex>
+#include <memory>
+
+// Receives the results of every timestep as soon as a results processor has finished it
+// Sinks may be called from the background thread of a progressive reconstruction, so they must be thread-safe.
+// Timesteps arrive in the order they were computed, and may be pushed again later (a later push supersedes an earlier one).
+class ResultsSink {
+public:
+	//'rows' has the same columns as the final table of the results processor called 'processor'
+	virtual void Push(const std::string& processor, const ResultsTable& rows) = 0;
+	virtual ~ResultsSink() {};
+};
+
+// Forwards every push to a list of sinks
+class ResultsSinkList : public ResultsSink {
+	std::vector<std::shared_ptr<ResultsSink>> sinks;
+	mutable std::mutex lock;
+public:
+	void Add(std::shared_ptr<ResultsSink> sink);
+	void Clear();
+	bool Empty() const;
+	void Push(const std::string& processor, const ResultsTable& rows) override;
+};
+
+// Appends the rows of every results processor to its own CSV file (<pathPrefix>_<processor>.csv), flushing after each timestep
+// The header is only written to new (or empty) files, so a restarted reconstruction continues the existing files.
+class FileResultsSink : public ResultsSink {
+	std::string pathPrefix;
+	std::map<std::string, std::ofstream> files;
+	std::mutex lock;
+public:
+	void Push(const std::string& processor, const ResultsTable& rows) override;
+	FileResultsSink(const std::string& prefix) : pathPrefix(prefix) {};
+};
+
+// Buffers pushed rows in memory until they are drained
+class MemoryResultsSink : public ResultsSink {
+	std::vector<std::pair<std::string, ResultsTable>> pending;
+	std::mutex lock;
+public:
+	void Push(const std::string& processor, const ResultsTable& rows) override;
+	//Returns the rows pushed since the last call, one table per results processor
+	std::vector<std::pair<std::string, ResultsTable>> Drain();
+};
+
+#ifdef PYTHON_LIB
+// Calls a Python function for every pushed row, as callback(processor, {column name: value})
+// Takes the GIL itself, so it may be called from any thread.
+class PythonResultsSink : public ResultsSink {
+	boost::python::object callback;
+public:
+	void Push(const std::string& processor, const ResultsTable& rows) override;
+	PythonResultsSink(boost::python::object cb);
+	~PythonResultsSink();
+};
+#endif
@@ -0,0 +1,223 @@
+#include "stdafx.h"
+#include "reconResultsTable.h"
+#include <cstdint>
+
+namespace {
+	const char TABLE_MAGIC[8] = {'H', 'L', '3', '8', 'T', 'B', 'L', '1'};
+};
+
+size_t ResultsTable::AddColumn(const std::string& name, bool fixedFormat) {
+	Column C;
+	C.name = name;
+	C.fixedFormat = fixedFormat;
+	cols.push_back(C);
+	return cols.size() - 1;
+};
+
+const ResultsTable::Column& ResultsTable::GetColumn(const std::string& name) const {
+	for (const auto& C : cols) {
+		if (C.name == name) {
+			return C;
+		};
+	};
+	throw std::runtime_error("Results table has no column '" + name + "'");
+};
+
+void ResultsTable::Reserve(size_t rows) {
+	for (auto& C : cols) {
+		C.data.reserve(rows);
+	};
+};
+
+void ResultsTable::Append(const ResultsTable& o) {
+	if (cols.empty()) {
+		cols = o.cols;
+		return;
+	};
+	if (o.cols.size() != cols.size()) {
+		throw std::runtime_error("Cannot append results tables with different columns");
+	};
+	for (size_t c = 0; c < cols.size(); ++c) {
+		cols[c].data.insert(cols[c].data.end(), o.cols[c].data.begin(), o.cols[c].data.end());
+	};
+};
+
+std::string ResultsTable::ToCSV() const {
+	return HeaderCSV() + RowsCSV();
+};
+
+std::string ResultsTable::HeaderCSV() const {
+	std::stringstream ss;
+	for (const auto& C : cols) {
+		ss << C.name << ",";
+	};
+	ss << std::endl;
+	return ss.str();
+};
+
+std::string ResultsTable::RowsCSV() const {
+	std::stringstream ss;
+	for (size_t r = 0; r < Rows(); ++r) {
+		for (const auto& C : cols) {
+			if (C.fixedFormat) {
+				ss << std::to_string(C.data[r]) << ",";
+			} else {
+				ss << C.data[r] << ",";
+			};
+		};
+		ss << std::endl;
+	};
+	return ss.str();
+};
+
+void ResultsTable::WriteBinary(const std::string& path) const {
+	std::ofstream f(path, std::ios::binary);
+	if (!f) {
+		throw std::runtime_error("Cannot open '" + path + "' for writing");
+	};
+	uint64_t nCols = cols.size();
+	uint64_t nRows = Rows();
+	f.write(TABLE_MAGIC, sizeof(TABLE_MAGIC));
+	f.write((const char*)&nCols, sizeof(nCols));
+	f.write((const char*)&nRows, sizeof(nRows));
+	for (const auto& C : cols) {
+		uint32_t len = (uint32_t)C.name.size();
+		f.write((const char*)&len, sizeof(len));
+		f.write(C.name.data(), len);
+		uint8_t fixedFormat = C.fixedFormat ? 1 : 0;
+		f.write((const char*)&fixedFormat, sizeof(fixedFormat));
+	};
+	for (const auto& C : cols) {
+		f.write((const char*)C.data.data(), nRows * sizeof(double));
+	};
+	if (!f) {
+		throw std::runtime_error("Failed writing results table to '" + path + "'");
+	};
+};
+
+ResultsTable ResultsTable::ReadBinary(const std::string& path) {
+	std::ifstream f(path, std::ios::binary | std::ios::ate);
+	const std::streamoff fileSize = f ? (std::streamoff)f.tellg() : 0;
+	f.seekg(0);
+	char magic[sizeof(TABLE_MAGIC)];
+	uint64_t nCols, nRows;
+	f.read(magic, sizeof(magic));
+	f.read((char*)&nCols, sizeof(nCols));
+	f.read((char*)&nRows, sizeof(nRows));
+	if (!f || !std::equal(magic, magic + sizeof(magic), TABLE_MAGIC)) {
+		throw std::runtime_error("'" + path + "' is not a results table");
+	};
+	//Sizes are checked against the rest of the file before anything is allocated
+	auto remaining = [&]() -> uint64_t { return (uint64_t)(fileSize - (std::streamoff)f.tellg()); };
+	auto truncated = [&]() { return std::runtime_error("'" + path + "' is truncated"); };
+	const uint64_t COLUMN_HEADER = sizeof(uint32_t) + sizeof(uint8_t);
+	if (nCols > remaining() / COLUMN_HEADER) {
+		throw truncated();
+	};
+	ResultsTable T;
+	for (uint64_t c = 0; c < nCols; ++c) {
+		uint32_t len;
+		f.read((char*)&len, sizeof(len));
+		if (!f || len > remaining()) {
+			throw truncated();
+		};
+		std::string name(len, ' ');
+		f.read(&name[0], len);
+		uint8_t fixedFormat = 0;
+		f.read((char*)&fixedFormat, sizeof(fixedFormat));
+		if (!f) {
+			throw truncated();
+		};
+		T.AddColumn(name, fixedFormat != 0);
+	};
+	if (nCols > 0 && nRows > remaining() / sizeof(double) / nCols) {
+		throw truncated();
+	};
+	for (auto& C : T.cols) {
+		C.data.resize(nRows);
+		f.read((char*)C.data.data(), nRows * sizeof(double));
+		if (!f) {
+			throw truncated();
+		};
+	};
+	return T;
+};
+
+#ifdef PYTHON_LIB
+boost::python::list ResultsTable::ColumnNames() const {
+	boost::python::list L;
+	for (const auto& C : cols) {
+		L.append(C.name);
+	};
+	return L;
+};
+
+namespace {
+	// Python buffer exporter for a single table column
+	// Holds a reference to the Python table object, so the column stays valid for as long as any view of it exists
+	struct ColumnBuffer {
+		PyObject_HEAD
+		PyObject* owner;
+		const double* data;
+		Py_ssize_t shape;
+		Py_ssize_t stride;
+	};
+
+	int ColumnBuffer_GetBuffer(PyObject* self, Py_buffer* view, int flags) {
+		ColumnBuffer* cb = (ColumnBuffer*)self;
+		if (flags & PyBUF_WRITABLE) {
+			PyErr_SetString(PyExc_BufferError, "Results table columns are read-only");
+			view->obj = NULL;
+			return -1;
+		};
+		view->obj = self;
+		Py_INCREF(self);
+		view->buf = (void*)cb->data;
+		view->len = cb->shape * sizeof(double);
+		view->readonly = 1;
+		view->itemsize = sizeof(double);
+		view->format = (flags & PyBUF_FORMAT) ? (char*)"d" : NULL;
+		view->ndim = 1;
+		view->shape = (flags & PyBUF_ND) ? &cb->shape : NULL;
+		view->strides = ((flags & PyBUF_STRIDES) == PyBUF_STRIDES) ? &cb->stride : NULL;
+		view->suboffsets = NULL;
+		view->internal = NULL;
+		return 0;
+	};
+
+	void ColumnBuffer_Dealloc(PyObject* self) {
+		Py_XDECREF(((ColumnBuffer*)self)->owner);
+		Py_TYPE(self)->tp_free(self);
+	};
+
+	PyTypeObject* ColumnBufferType() {
+		static PyBufferProcs procs = {&ColumnBuffer_GetBuffer, NULL};
+		static PyTypeObject T = {PyVarObject_HEAD_INIT(NULL, 0)};
+		if (!T.tp_name) {
+			T.tp_name = "HL888.ResultsColumnBuffer";
+			T.tp_basicsize = sizeof(ColumnBuffer);
+			T.tp_flags = Py_TPFLAGS_DEFAULT;
+			T.tp_dealloc = &ColumnBuffer_Dealloc;
+			T.tp_as_buffer = &procs;
+			PyType_Ready(&T);
+		};
+		return &T;
+	};
+};
+
+boost::python::object ResultsTable::ColumnView(boost::python::object self, const std::string& name) {
+	static const double empty = 0.0;
+	const ResultsTable& table = boost::python::extract<const ResultsTable&>(self);
+	const Column& C = table.GetColumn(name);
+
+	ColumnBuffer* cb = PyObject_New(ColumnBuffer, ColumnBufferType());
+	cb->owner = self.ptr();
+	Py_INCREF(cb->owner);
+	cb->data = C.data.empty() ? &empty : C.data.data();
+	cb->shape = C.data.size();
+	cb->stride = sizeof(double);
+	PyObject* view = PyMemoryView_FromObject((PyObject*)cb);
+	Py_DECREF(cb);
+	return boost::python::object(boost::python::handle<>(view));
+};
+#endif
@@ -0,0 +1,50 @@
+#pragma once
+#include "utils.h"
+#include "pyLib.h"
+
+// Columnar table of reconstruction results
+// Every column is a contiguous buffer of doubles, so that it can be handed to Python (as a memoryview) or written to disk without formatting.
+// CSV output is still available as an explicit export.
+class ResultsTable {
+public:
+	struct Column {
+		std::string name;
+		bool fixedFormat;	//CSV formatting: std::to_string (fixed, 6 decimals) rather than the default stream formatting
+		std::vector<double> data;
+	};
+private:
+	std::vector<Column> cols;
+public:
+	//Adds a new column, returns its index
+	size_t AddColumn(const std::string& name, bool fixedFormat = false);
+	std::vector<double>& operator[](size_t idx) { return cols[idx].data; };
+	const std::vector<double>& operator[](size_t idx) const { return cols[idx].data; };
+	const Column& GetColumn(size_t idx) const { return cols[idx]; };
+	//Throws if no column of that name exists
+	const Column& GetColumn(const std::string& name) const;
+
+	size_t Columns() const { return cols.size(); };
+	size_t Rows() const { return cols.empty() ? 0 : cols.front().data.size(); };
+	void Reserve(size_t rows);
+
+	//Appends the rows of a table with the same columns
+	void Append(const ResultsTable& o);
+
+	std::string ToCSV() const;
+	std::string HeaderCSV() const;
+	std::string RowsCSV() const;
+
+	// Binary columnar file: "HL38TBL1", column count & row count (uint64), then every column header (uint32 name length, name characters,
+	// uint8 CSV format flag), followed by the data of each column in turn (rows x float64, native byte order)
+	void WriteBinary(const std::string& path) const;
+	static ResultsTable ReadBinary(const std::string& path);
+
+#ifdef PYTHON_LIB
+	boost::python::list ColumnNames() const;
+	//Returns a read-only memoryview (format 'd') of a column's data, which keeps the Python table object alive
+	static boost::python::object ColumnView(boost::python::object self, const std::string& name);
+#endif
+};
+
+//Outputs of a reconstruction: (results processor name, results table) pairs
+typedef std::vector<std::pair<std::string, ResultsTable>> ReconOutputs;
@@ -5,6 +5,7 @@
 #include <boost/random/uniform_int_distribution.hpp>
 #include <boost/random/uniform_01.hpp>
 #include <boost/random/normal_distribution.hpp>
+#include <boost/random/seed_seq.hpp>
 
 boost::random::mt19937 gen;
 boost::normal_distribution<> stdDev(0.0, 1.0);
@@ -51,6 +52,40 @@ double Random::NormDstr(double mean, double sigma) {
 	return distr(gen);
 };
 
+uint64 Random::Seed() {
+	boost::random::uniform_int_distribution<uint64> dist;
+	return dist(gen);
+};
+
+Random::Stream::Stream(uint64 seed, uint64 index) {
+	//SplitMix64 finaliser: neighbouring indices give unrelated seeds
+	uint64 z = seed + (index + 1) * 0x9E3779B97F4A7C15ULL;
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	z = z ^ (z >> 31);
+	boost::random::seed_seq seq = {(uint32_t)z, (uint32_t)(z >> 32)};
+	gen.seed(seq);
+};
+
+int64 Random::Stream::Int64(int64 lowerBound, int64 upperBound) {
+	boost::random::uniform_int_distribution<int64> dist(lowerBound, upperBound);
+	return dist(gen);
+};
+
+double Random::Stream::Double() {
+	boost::random::uniform_01<> dist;
+	return dist(gen);
+};
+
+double Random::Stream::NormDstr(double mean, double sigma) {
+	boost::normal_distribution<> distr(mean, sigma);
+	return distr(gen);
+};
+
+size_t Parallel::DefaultThreadCount() {
+	return std::max<unsigned>(1, std::thread::hardware_concurrency());
+};
+
 std::string ToFilenameString(const std::string & S) {
 	std::string s;
 	s.reserve(S.size());
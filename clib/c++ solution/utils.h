@@ -2,8 +2,14 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <algorithm>
 #include <iostream>
 #include <dirent.h>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <exception>
+#include <boost/random/mersenne_twister.hpp>
 
 /// ...................................................................................................................
 /// 64-bit integer (signed & unsiged)
@@ -203,6 +209,83 @@ namespace Random {
 
 	//Produces a random double drawn from an arbitrary normal distribution
 	double NormDstr(double mean, double sigma);
+
+	//Draws a seed for a family of independent streams from the global generator
+	uint64 Seed();
+
+	//Independent random number stream, fully determined by (seed, index)
+	//Lets parallel tasks draw reproducible numbers, whichever thread runs them and in whatever order.
+	class Stream {
+		boost::random::mt19937 gen;
+	public:
+		int64 Int64(int64 lowerBound, int64 upperBound);
+		double Double();
+		double NormDstr(double mean, double sigma);
+		Stream(uint64 seed, uint64 index);
+	};
+
+	//Same interface as Stream, drawing from the global generator
+	struct Global {
+		int64 Int64(int64 lowerBound, int64 upperBound) { return Random::Int64(lowerBound, upperBound); };
+		double Double() { return Random::Double(); };
+		double NormDstr(double mean, double sigma) { return Random::NormDstr(mean, sigma); };
+	};
+};
+
+/// ...................................................................................................................
+/// Parallel execution
+/// 
+/// ...................................................................................................................
+namespace Parallel {
+	//Number of threads used when none is requested (the hardware concurrency)
+	size_t DefaultThreadCount();
+
+	//Calls f(thread, i) for every i in [0, count), spread over 'threads' worker threads (zero for the default)
+	//Indices are handed out in small chunks; 'thread' (< thread count) identifies the worker, e.g. for per-thread scratch buffers.
+	//The first exception thrown by any worker is rethrown once all workers have finished.
+	template<typename F>
+	void For(size_t count, size_t threads, F f) {
+		if (threads == 0) {
+			threads = DefaultThreadCount();
+		};
+		threads = std::max<size_t>(1, std::min(threads, count));
+		if (threads == 1) {
+			for (size_t i = 0; i < count; ++i) {
+				f(0, i);
+			};
+			return;
+		};
+		const size_t CHUNK = std::max<size_t>(1, count / (threads * 16));
+		std::atomic<size_t> next(0);
+		std::exception_ptr error;
+		std::mutex errorLock;
+		auto WORKER = [&](size_t thread) {
+			try {
+				for (size_t i0 = next.fetch_add(CHUNK); i0 < count; i0 = next.fetch_add(CHUNK)) {
+					for (size_t i = i0; i < std::min(count, i0 + CHUNK); ++i) {
+						f(thread, i);
+					};
+				};
+			} catch (...) {
+				std::lock_guard<std::mutex> guard(errorLock);
+				if (!error) {
+					error = std::current_exception();
+				};
+				next = count;
+			};
+		};
+		std::vector<std::thread> pool;
+		for (size_t t = 1; t < threads; ++t) {
+			pool.push_back(std::thread(WORKER, t));
+		};
+		WORKER(0);
+		for (auto& T : pool) {
+			T.join();
+		};
+		if (error) {
+			std::rethrow_exception(error);
+		};
+	};
 };
 /// ...................................................................................................................
 /// Container print functions